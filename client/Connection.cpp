@@ -0,0 +1,50 @@
+#include "Connection.hpp"
+
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cstring>
+
+TcpConnection::TcpConnection(const char* server_addr, uint16_t port)
+{
+  // init socket
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  inet_aton(server_addr, &(address.sin_addr));
+  address.sin_port = htons(port);
+  // connect to server
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    perror("connect()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+TcpConnection::~TcpConnection()
+{
+  close(fd);
+}
+
+void TcpConnection::write(const std::vector<uint8_t>& msg)
+{
+  size_t written = 0;
+  ssize_t n;
+  while (written != msg.size()) {
+    if ((n = ::write(fd, &msg[0] + written, msg.size() - written)) < 0) {
+      perror("write()");
+      exit(EXIT_FAILURE);
+    } else {
+      written += n;
+    }
+  }
+}
+
+void TcpConnection::resetOnClose()
+{
+  struct linger linger = {1, 0};
+  if (setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)) == -1) {
+    perror("setsockopt(SO_LINGER)");
+    exit(EXIT_FAILURE);
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ShmChannel.hpp"
+
+// connection to the server over TCP
+class TcpConnection
+{
+ public:
+  TcpConnection(const char* address, uint16_t port);
+  ~TcpConnection();
+
+  void write(const std::vector<uint8_t>& msg);
+  // send a RST instead of a FIN on close, so the socket does not linger in TIME_WAIT
+  void resetOnClose();
+
+  // pass all bytes that already arrived to protocol without blocking
+  template <typename Protocol>
+  void readAvailable(Protocol& protocol)
+  {
+    uint8_t buf[4096];
+    for (;;) {
+      ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (n > 0) {
+        protocol.receive(buf, n);
+      } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+      } else {
+        perror("recv()");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+
+  // block until some bytes arrived and pass them to protocol
+  template <typename Protocol>
+  void readBlocking(Protocol& protocol)
+  {
+    uint8_t buf[4096];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      perror("recv()");
+      exit(EXIT_FAILURE);
+    }
+    protocol.receive(buf, n);
+  }
+
+ private:
+  int fd;
+};
+
+// connection to a co-located server through a shared memory channel
+// requests are written into and responses parsed directly from the rings, the doorbells are only used when a side sleeps
+class ShmConnection
+{
+ public:
+  ShmConnection(const char* path) { channel.connect(path); }
+
+  void write(const std::vector<uint8_t>& msg) { channel.writeAll(msg.data(), msg.size()); }
+
+  template <typename Protocol>
+  void readAvailable(Protocol& protocol)
+  {
+    channel.drain([&](Net::ByteView data) { protocol.receive(data.data, data.size); });
+  }
+
+  template <typename Protocol>
+  void readBlocking(Protocol& protocol)
+  {
+    channel.awaitData();
+    readAvailable(protocol);
+  }
+
+ private:
+  Net::ShmChannel channel;
+};
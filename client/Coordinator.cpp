@@ -0,0 +1,176 @@
+#include "Coordinator.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+void writeAll(int fd, const void* data, size_t length)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (length != 0) {
+    ssize_t n = write(fd, bytes, length);
+    if (n == -1) {
+      perror("write(coordinator)");
+      exit(EXIT_FAILURE);
+    }
+    bytes += n;
+    length -= n;
+  }
+}
+
+void readAll(int fd, void* data, size_t length)
+{
+  uint8_t* bytes = static_cast<uint8_t*>(data);
+  while (length != 0) {
+    ssize_t n = read(fd, bytes, length);
+    if (n <= 0) {
+      if (n == 0)
+        fprintf(stderr, "coordinator connection closed\n");
+      else
+        perror("read(coordinator)");
+      exit(EXIT_FAILURE);
+    }
+    bytes += n;
+    length -= n;
+  }
+}
+
+sockaddr_un unixAddress(const char* path)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  strcpy(address.sun_path, path);
+  return address;
+}
+}  // namespace
+
+// the processes run the same binary on the same host, so the report is sent in memory layout
+static_assert(std::is_trivially_copyable_v<Stats::Histogram>);
+
+void Report::merge(const Report& other)
+{
+  events += other.events;
+  busy += other.busy;
+  connects += other.connects;
+  latency.merge(other.latency);
+  warehouseEvents.resize(std::max(warehouseEvents.size(), other.warehouseEvents.size()));
+  for (size_t w_i = 0; w_i < other.warehouseEvents.size(); w_i++)
+    warehouseEvents[w_i] += other.warehouseEvents[w_i];
+}
+
+void Report::send(int fd) const
+{
+  uint64_t header[] = {events, busy, connects, warehouseEvents.size()};
+  writeAll(fd, header, sizeof(header));
+  writeAll(fd, &latency, sizeof(latency));
+  writeAll(fd, warehouseEvents.data(), warehouseEvents.size() * sizeof(uint64_t));
+}
+
+void Report::receive(int fd)
+{
+  uint64_t header[4];
+  readAll(fd, header, sizeof(header));
+  events = header[0];
+  busy = header[1];
+  connects = header[2];
+  readAll(fd, &latency, sizeof(latency));
+  warehouseEvents.resize(header[3]);
+  readAll(fd, warehouseEvents.data(), warehouseEvents.size() * sizeof(uint64_t));
+}
+
+namespace Coordinator
+{
+int forkWorkers(int count, std::vector<int>& workerFds)
+{
+  for (int i = 0; i < count; i++) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+      perror("socketpair()");
+      exit(EXIT_FAILURE);
+    }
+    pid_t pid = fork();
+    if (pid == -1) {
+      perror("fork()");
+      exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+      // worker: only keeps its own end
+      for (int fd : workerFds)
+        close(fd);
+      workerFds.clear();
+      close(fds[0]);
+      return fds[1];
+    }
+    close(fds[1]);
+    workerFds.push_back(fds[0]);
+  }
+  return -1;
+}
+
+std::vector<int> acceptWorkers(const char* path, int count)
+{
+  int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listenFd == -1) {
+    perror("socket()");
+    exit(EXIT_FAILURE);
+  }
+  sockaddr_un address = unixAddress(path);
+  unlink(path);
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 || listen(listenFd, count) == -1) {
+    perror("bind()/listen()");
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<int> workerFds;
+  while (static_cast<int>(workerFds.size()) < count) {
+    int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd == -1) {
+      perror("accept4()");
+      exit(EXIT_FAILURE);
+    }
+    workerFds.push_back(fd);
+  }
+  close(listenFd);
+  unlink(path);
+  return workerFds;
+}
+
+int attach(const char* path)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un address = unixAddress(path);
+  if (fd == -1 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+    perror("connect(coordinator)");
+    exit(EXIT_FAILURE);
+  }
+  return fd;
+}
+
+void send(int fd, Command command)
+{
+  writeAll(fd, &command, sizeof(command));
+}
+
+void expect(int fd, Command command)
+{
+  Command received;
+  readAll(fd, &received, sizeof(received));
+  if (received != command) {
+    fprintf(stderr, "unexpected coordinator command '%c'\n", static_cast<char>(received));
+    exit(EXIT_FAILURE);
+  }
+}
+}  // namespace Coordinator
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Stats/Histogram.hpp"
+
+// counters of one measurement window, collected from the threads of a process and merged over all worker processes
+struct Report {
+  uint64_t events = 0;
+  uint64_t busy = 0;
+  uint64_t connects = 0;
+  // round trip times, only recorded in closed loop mode
+  Stats::Histogram latency;
+  // answered requests per home warehouse, indexed by w_id - 1
+  std::vector<uint64_t> warehouseEvents;
+
+  void merge(const Report& other);
+  void send(int fd) const;
+  void receive(int fd);
+};
+
+// synchronizes the worker processes of a coordinated run over stream sockets
+// a worker sends ready once all of its threads are connected, the coordinator waits for all of them, lets the warmup
+// pass and then opens and closes the measurement window of all workers at the same time. On stop every worker
+// answers with its Report and exits.
+namespace Coordinator
+{
+enum class Command : char { ready = 'R', start = 'S', stop = 'E' };
+
+// fork count worker processes connected through socket pairs
+// returns -1 in the coordinator, which gets one socket per worker in workerFds, and the coordinator socket in a worker
+int forkWorkers(int count, std::vector<int>& workerFds);
+// wait for count worker processes started with --attach=path
+std::vector<int> acceptWorkers(const char* path, int count);
+// connect to a coordinator waiting on path, returns the coordinator socket
+int attach(const char* path);
+
+void send(int fd, Command command);
+// blocks until the command arrives, exits if the other side is gone or sent something else
+void expect(int fd, Command command);
+}  // namespace Coordinator
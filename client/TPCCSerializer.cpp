@@ -4,6 +4,8 @@
 
 #include <type_traits>
 
+#include "TPCC/Response.hpp"
+
 namespace TPCC
 {
 // pre c++20 bit_cast using memcpy (from cppreference.com)
@@ -130,4 +132,10 @@ void serializePaymentByName(std::vector<uint8_t>& buf,
   push64(buf, bit_cast<uint64_t>(h_amount));
   push64(buf, datetime);
 }
+
+void serializeBatchHeader(std::vector<uint8_t>& buf, uint8_t count)
+{
+  buf.push_back(BATCH_FRAME_ID);
+  buf.push_back(count);
+}
 }  // namespace TPCC
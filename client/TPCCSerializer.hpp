@@ -1,6 +1,6 @@
 #include <vector>
 
-#include "types.hpp"
+#include "TPCC/Types.hpp"
 
 namespace TPCC
 {
@@ -35,4 +35,6 @@ void serializePaymentByName(std::vector<uint8_t>& buf,
                             Timestamp h_date,
                             Numeric h_amount,
                             Timestamp datetime);
+// header of a batch frame, the count requests serialized after it are answered by one response frame
+void serializeBatchHeader(std::vector<uint8_t>& buf, uint8_t count);
 }  // namespace TPCC
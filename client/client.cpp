@@ -1,65 +1,210 @@
-#include <arpa/inet.h>
+#include <getopt.h>
 #include <pthread.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <string>
 #include <thread>
 
+#include "Connection.hpp"
+#include "Coordinator.hpp"
+#include "PacketProtocol.hpp"
+#include "Stats/Histogram.hpp"
+#include "Sys/Affinity.hpp"
+#include "TPCC/Response.hpp"
 #include "workload.hpp"
 
 constexpr auto USE_POISSON = false;
 constexpr auto POISSON_LAMBDA = 3.5;
-constexpr auto SETUP_TIME = 10;
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(5);
+
+// round trip times of one thread, locked by the reporting thread to read and reset them
+struct alignas(64) ThreadLatency {
+  std::mutex latch;
+  // since the last interval report
+  Stats::Histogram histogram;
+  // since the start of the measurement window, recorded while count_events is set
+  Stats::Histogram window;
+};
 
 struct ThreadData {
   std::atomic<bool> keep_running{true};
   std::atomic<bool> count_events{false};
   std::atomic<uint64_t> event_count{0};
+  std::atomic<uint64_t> busy_count{0};
   std::vector<uint8_t>* message;
   char* server_addr;
   uint16_t port;
+  // cores the client threads are pinned to round-robin, empty = no pinning
+  std::vector<int> cores;
+  // send the next request only after the previous one was answered and record its round trip time
+  bool closed_loop = false;
+  // requests sent together in a batch frame, 0 = every request on its own
+  uint frame_size = 0;
+  std::unique_ptr<ThreadLatency[]> latencies;
+  // connect through a shared memory channel set up on this Unix socket instead of TCP
+  char* shm_path = nullptr;
+  // benchmark connection setup: open a connection, send one request, wait for its response and close, repeatedly
+  bool connect_storm = false;
+  std::atomic<uint64_t> connect_count{0};
+  // answered requests per home warehouse, indexed by w_id - 1
+  std::unique_ptr<std::atomic<uint64_t>[]> warehouse_counts;
+  uint thread_count;
+  // threads that are connected and sending
+  std::atomic<uint> started{0};
 };
 
-void writeMessage(int fd, std::vector<uint8_t>& msg)
+// the counters only grow, reports are the difference of two snapshots
+Report snapshot(ThreadData& thread_data)
 {
-  size_t written = 0;
-  ssize_t n;
-  while (written != msg.size()) {
-    if ((n = write(fd, &msg[0] + written, msg.size() - written)) < 0) {
-      perror("write()");
-      exit(EXIT_FAILURE);
-    } else {
-      written += n;
-    }
+  Report report;
+  report.events = thread_data.event_count;
+  report.busy = thread_data.busy_count;
+  report.connects = thread_data.connect_count;
+  report.warehouseEvents.resize(TPCC::warehouseCount);
+  for (Integer w_i = 0; w_i < TPCC::warehouseCount; w_i++)
+    report.warehouseEvents[w_i] = thread_data.warehouse_counts[w_i];
+  return report;
+}
+
+Report difference(const Report& end, const Report& begin)
+{
+  Report report;
+  report.events = end.events - begin.events;
+  report.busy = end.busy - begin.busy;
+  report.connects = end.connects - begin.connects;
+  report.warehouseEvents.resize(end.warehouseEvents.size());
+  for (size_t w_i = 0; w_i < end.warehouseEvents.size(); w_i++)
+    report.warehouseEvents[w_i] = end.warehouseEvents[w_i] - begin.warehouseEvents[w_i];
+  return report;
+}
+
+// start recording the round trip times of the measurement window
+void openWindow(ThreadData& thread_data)
+{
+  for (uint t_i = 0; t_i < thread_data.thread_count; t_i++) {
+    std::lock_guard<std::mutex> guard(thread_data.latencies[t_i].latch);
+    thread_data.latencies[t_i].window.reset();
   }
+  thread_data.count_events = true;
 }
 
-void runThread(ThreadData& thread_data)
+Stats::Histogram closeWindow(ThreadData& thread_data)
 {
-  // init socket
-  struct sockaddr_in address;
-  memset(&address, 0, sizeof(address));
-  address.sin_family = AF_INET;
-  inet_aton(thread_data.server_addr, &(address.sin_addr));
-  address.sin_port = htons(thread_data.port);
-  // connect to server
-  int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-  if (connect(sockfd, (struct sockaddr*)&address, sizeof(address)) == -1) {
-    perror("connect()");
-    exit(EXIT_FAILURE);
+  thread_data.count_events = false;
+  Stats::Histogram latency;
+  for (uint t_i = 0; t_i < thread_data.thread_count; t_i++) {
+    std::lock_guard<std::mutex> guard(thread_data.latencies[t_i].latch);
+    latency.merge(thread_data.latencies[t_i].window);
   }
+  return latency;
+}
 
+// per warehouse answered requests per second: min, average and max over the warehouses, then warehouse 1, 2, ...
+void printWarehouses(const Report& report, double mSec)
+{
+  if (report.warehouseEvents.size() <= 1)
+    return;
+  std::vector<double> rates;
+  for (uint64_t events : report.warehouseEvents)
+    rates.push_back(events * 1000 / mSec);
+  auto [min, max] = std::minmax_element(rates.begin(), rates.end());
+  std::cout << "warehouses " << *min << " " << report.events * 1000 / mSec / rates.size() << " " << *max << ":";
+  for (double rate : rates)
+    std::cout << " " << rate;
+  std::cout << std::endl;
+}
+
+// final report of the measurement window, summed over all threads and processes
+void printSummary(const Report& report, double mSec, bool connect_storm, bool closed_loop)
+{
+  std::cout << "events\tseconds\tevents/s\tbusy";
+  if (connect_storm)
+    std::cout << "\tconnects/s";
+  if (closed_loop)
+    std::cout << "\tp50 us\tp99 us\tp99.9 us\tmax us\tmean us";
+  std::cout << "\n" << report.events << "\t" << mSec / 1000 << "\t" << report.events * 1000 / mSec << "\t" << report.busy;
+  if (connect_storm)
+    std::cout << "\t" << report.connects * 1000 / mSec;
+  if (closed_loop) {
+    const Stats::Histogram& latency = report.latency;
+    std::cout << "\t" << latency.percentile(0.5) / 1000.0 << "\t" << latency.percentile(0.99) / 1000.0 << "\t"
+              << latency.percentile(0.999) / 1000.0 << "\t" << latency.max() / 1000.0 << "\t" << latency.mean() / 1000.0;
+  }
+  std::cout << std::endl;
+  printWarehouses(report, mSec);
+}
+
+// home warehouses of a thread, warehouse w belongs to thread (w - 1) % thread_count, so every warehouse has terminals as
+// long as there are at least as many warehouses as threads, and several threads share a warehouse otherwise
+class HomeWarehouses
+{
+ public:
+  HomeWarehouses(int thread_index, uint thread_count)
+  {
+    for (Integer w_id = thread_index % TPCC::warehouseCount + 1; w_id <= TPCC::warehouseCount; w_id += thread_count)
+      ids.push_back(w_id);
+  }
+
+  // the warehouse of the terminal issuing the next transaction
+  Integer next() const { return ids.size() == 1 ? ids[0] : ids[TPCC::rnd(ids.size())]; }
+
+ private:
+  std::vector<Integer> ids;
+};
+
+template <typename Connection>
+void runConnection(ThreadData& thread_data, int thread_index, Connection& connection)
+{
   std::default_random_engine generator;
   std::exponential_distribution<double> distribution(POISSON_LAMBDA);
   std::atomic<int> packets_pending{0};
   std::vector<uint8_t> buf;
+  HomeWarehouses home(thread_index, thread_data.thread_count);
+  // home warehouse of every request in flight, responses arrive in request order
+  std::deque<Integer> pending_warehouses;
+  thread_data.started++;
 
-  std::cout << std::hex;
+  uint64_t sent = 0;
+  uint64_t received = 0;
+  auto onAnswer = [&](const uint8_t* response) {
+    received++;
+    Integer w_id = pending_warehouses.front();
+    pending_warehouses.pop_front();
+    if (static_cast<TPCC::ResponseCode>(response[1]) == TPCC::ResponseCode::busy) {
+      thread_data.busy_count++;
+    } else {
+      thread_data.event_count++;
+      thread_data.warehouse_counts[w_id - 1].fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+  auto onResponse = [&](Net::ByteView response) {
+    if (response[0] != TPCC::BATCH_FRAME_ID) {
+      onAnswer(response.data);
+      return;
+    }
+    // the entries of a response frame have the same size, with or without the server's timing
+    size_t count = response.size >= TPCC::BATCH_HEADER_SIZE ? response[1] : 0;
+    if (count == 0 || (response.size - TPCC::BATCH_HEADER_SIZE) % count != 0 ||
+        (response.size - TPCC::BATCH_HEADER_SIZE) / count < TPCC::BATCH_ENTRY_SIZE) {
+      std::cerr << "malformed response frame of " << response.size << " bytes\n";
+      exit(EXIT_FAILURE);
+    }
+    size_t entrySize = (response.size - TPCC::BATCH_HEADER_SIZE) / count;
+    for (size_t i = 0; i < count; i++)
+      onAnswer(response.data + TPCC::BATCH_HEADER_SIZE + i * entrySize);
+  };
+  Net::PacketProtocol<decltype(onResponse), TPCC::RESPONSE_PREFIX_FORMAT> responses(onResponse);
 
   // main loop
   while (thread_data.keep_running) {
@@ -69,9 +214,29 @@ void runThread(ThreadData& thread_data)
       pthread_yield();
     }
     */
-    TPCC::tx(buf, 0);
-    writeMessage(sockfd, buf);
+    if (thread_data.frame_size)
+      TPCC::serializeBatchHeader(buf, thread_data.frame_size);
+    for (uint r_i = 0; r_i < std::max(1u, thread_data.frame_size); r_i++) {
+      Integer w_id = home.next();
+      TPCC::tx(buf, w_id);
+      pending_warehouses.push_back(w_id);
+      sent++;
+    }
+    auto sendTime = std::chrono::steady_clock::now();
+    connection.write(buf);
     buf.clear();
+    if (thread_data.closed_loop) {
+      while (received < sent)
+        connection.readBlocking(responses);
+      std::chrono::nanoseconds rtt = std::chrono::steady_clock::now() - sendTime;
+      ThreadLatency& latency = thread_data.latencies[thread_index];
+      std::lock_guard<std::mutex> guard(latency.latch);
+      latency.histogram.record(rtt.count());
+      if (thread_data.count_events)
+        latency.window.record(rtt.count());
+    } else {
+      connection.readAvailable(responses);
+    }
     //    packets_pending++;
 
     // wait for an exponential distributed amount of time (poisson process)
@@ -80,60 +245,306 @@ void runThread(ThreadData& thread_data)
       std::this_thread::sleep_for(std::chrono::milliseconds(i));
     }
   }
+}
+
+void runConnectStorm(ThreadData& thread_data, int thread_index)
+{
+  std::vector<uint8_t> buf;
+  HomeWarehouses home(thread_index, thread_data.thread_count);
+  uint64_t received = 0;
+  thread_data.started++;
+  auto onResponse = [&](Net::ByteView) { received++; };
 
-  close(sockfd);
+  while (thread_data.keep_running) {
+    TcpConnection connection(thread_data.server_addr, thread_data.port);
+    // close with a reset, otherwise the client runs out of ports in TIME_WAIT long before the server is saturated
+    connection.resetOnClose();
+    Net::PacketProtocol<decltype(onResponse), TPCC::RESPONSE_PREFIX_FORMAT> responses(onResponse);
+    TPCC::tx(buf, home.next());
+    connection.write(buf);
+    buf.clear();
+    received = 0;
+    while (received == 0)
+      connection.readBlocking(responses);
+    thread_data.connect_count++;
+  }
 }
 
-int main(int argc, char* argv[])
+void runThread(ThreadData& thread_data, int thread_index)
 {
-  if (argc != 6) {
-    std::cout << "Usage: " << argv[0] << " <ip address> <port> <number of threads> <testing time in s> <packet size in byte>" << std::endl;
-    return 1;
+  if (!thread_data.cores.empty())
+    Sys::pinThread(thread_data.cores[thread_index % thread_data.cores.size()]);
+
+  if (thread_data.connect_storm) {
+    runConnectStorm(thread_data, thread_index);
+  } else if (thread_data.shm_path) {
+    ShmConnection connection(thread_data.shm_path);
+    runConnection(thread_data, thread_index, connection);
+  } else {
+    TcpConnection connection(thread_data.server_addr, thread_data.port);
+    runConnection(thread_data, thread_index, connection);
   }
+}
+
+static void printUsage(const char* name)
+{
+  std::cout << "Usage: " << name << " <ip address> <port> <number of threads> <testing time in s> <packet size in byte> [options]\n"
+            << "Options:\n"
+            << "  --cores=<list>    pin client threads round-robin to cores, e.g. 0-7,16-23\n"
+            << "  --closed-loop     wait for each response before sending the next request and report round trip times\n"
+            << "  --frame=<n>       send requests in batch frames of n (1-255), answered by one response frame each\n"
+            << "  --shm=<path>      talk to a server on the same host through shared memory set up on its Unix socket\n"
+            << "  --connect-storm   connect, send one request and disconnect in a loop, reports connections per second\n"
+            << "  --warehouses=<n>  warehouses of the server, spread over the threads as home warehouses (default 1)\n"
+            << "                    reports the answered requests per second of every warehouse if n > 1\n"
+            << "  --mix=<weights>   comma separated weights of the function ids 1-7 (NewOrder, Delivery, StockLevel,\n"
+            << "                    OrderStatusId, OrderStatusName, PaymentById, PaymentByName), drawn from a shuffled deck\n"
+            << "                    so every sum(weights) requests match them exactly (default 450,40,40,16,24,172,258)\n"
+            << "  --only=<id>       send only requests of function id 1-7\n"
+            << "  --warmup=<s>      seconds before the measurement window opens (default 0), the run ends with a summary of\n"
+            << "                    the window after <testing time>\n"
+            << "  --processes=<n>   coordinate n worker processes, each running <number of threads> threads, and merge their\n"
+            << "                    counters and latency histograms into one summary\n"
+            << "  --workers=<path>  wait for the --processes workers to attach on this Unix socket instead of forking them\n"
+            << "  --attach=<path>   run as a worker of the coordinator waiting on this Unix socket\n";
+}
+
+// coordinator of a multi-process run, does not send requests itself
+int coordinate(const std::vector<int>& worker_fds, uint warmup_seconds, uint run_seconds, bool connect_storm, bool closed_loop)
+{
+  for (int fd : worker_fds)
+    Coordinator::expect(fd, Coordinator::Command::ready);
+  std::cout << worker_fds.size() << " workers ready" << std::endl;
+  std::this_thread::sleep_for(std::chrono::seconds(warmup_seconds));
+
+  auto windowStart = std::chrono::steady_clock::now();
+  for (int fd : worker_fds)
+    Coordinator::send(fd, Coordinator::Command::start);
+  std::this_thread::sleep_for(std::chrono::seconds(run_seconds));
+  for (int fd : worker_fds)
+    Coordinator::send(fd, Coordinator::Command::stop);
+  std::chrono::duration<double, std::milli> mSec = std::chrono::steady_clock::now() - windowStart;
 
+  Report total;
+  for (int fd : worker_fds) {
+    Report report;
+    report.receive(fd);
+    total.merge(report);
+    close(fd);
+  }
+  printSummary(total, mSec.count(), connect_storm, closed_loop);
+  while (wait(nullptr) > 0)
+    ;
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
   ThreadData thread_data;
   uint thread_count;
   uint run_seconds;
+  uint warmup_seconds = 0;
+  int process_count = 0;
+  char* workers_path = nullptr;
+  char* attach_path = nullptr;
   std::vector<uint8_t> message;
 
+  static const struct option options[] = {{"cores", required_argument, nullptr, 'c'},
+                                          {"closed-loop", no_argument, nullptr, 'l'},
+                                          {"frame", required_argument, nullptr, 'f'},
+                                          {"shm", required_argument, nullptr, 'm'},
+                                          {"connect-storm", no_argument, nullptr, 's'},
+                                          {"warehouses", required_argument, nullptr, 'w'},
+                                          {"mix", required_argument, nullptr, 'x'},
+                                          {"only", required_argument, nullptr, 'o'},
+                                          {"warmup", required_argument, nullptr, 'u'},
+                                          {"processes", required_argument, nullptr, 'p'},
+                                          {"workers", required_argument, nullptr, 'W'},
+                                          {"attach", required_argument, nullptr, 'a'},
+                                          {nullptr, 0, nullptr, 0}};
   try {
-    thread_data.server_addr = argv[1];
-    thread_data.port = std::stoi(argv[2]);
-    thread_count = std::stoi(argv[3]);
-    run_seconds = std::stoi(argv[4]);
-    message.insert(message.begin(), std::stoi(argv[5]), 'a');
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, nullptr)) != -1) {
+      switch (opt) {
+        case 'c':
+          thread_data.cores = Sys::parseCoreList(optarg);
+          break;
+        case 'l':
+          thread_data.closed_loop = true;
+          break;
+        case 'f': {
+          int frame_size = std::stoi(optarg);
+          if (frame_size < 1 || frame_size > UINT8_MAX)
+            throw std::invalid_argument("--frame expects 1 to 255 requests");
+          thread_data.frame_size = frame_size;
+          break;
+        }
+        case 'm':
+          thread_data.shm_path = optarg;
+          break;
+        case 's':
+          thread_data.connect_storm = true;
+          break;
+        case 'w':
+          TPCC::warehouseCount = std::stoi(optarg);
+          if (TPCC::warehouseCount < 1)
+            throw std::invalid_argument("--warehouses must be at least 1");
+          break;
+        case 'x': {
+          std::string list = optarg;
+          size_t begin = 0;
+          for (Integer& weight : TPCC::mix) {
+            if (begin > list.size())
+              throw std::invalid_argument("--mix expects 7 weights");
+            size_t end = std::min(list.find(',', begin), list.size());
+            weight = std::stoi(list.substr(begin, end - begin));
+            if (weight < 0)
+              throw std::invalid_argument("--mix weights must not be negative");
+            begin = end + 1;
+          }
+          if (begin <= list.size())
+            throw std::invalid_argument("--mix expects 7 weights");
+          break;
+        }
+        case 'o': {
+          int funcID = std::stoi(optarg);
+          if (funcID < 1 || funcID > TPCC::TRANSACTION_TYPES)
+            throw std::invalid_argument("--only expects a function id from 1 to 7");
+          TPCC::mix.fill(0);
+          TPCC::mix[funcID - 1] = 1;
+          break;
+        }
+        case 'u':
+          warmup_seconds = std::stoul(optarg);
+          break;
+        case 'p':
+          process_count = std::stoi(optarg);
+          break;
+        case 'W':
+          workers_path = optarg;
+          break;
+        case 'a':
+          attach_path = optarg;
+          break;
+        default:
+          printUsage(argv[0]);
+          return 1;
+      }
+    }
+
+    if (argc - optind != 5) {
+      printUsage(argv[0]);
+      return 1;
+    }
+    if (workers_path && process_count <= 0)
+      throw std::invalid_argument("--workers needs --processes");
+    if (attach_path && process_count > 0)
+      throw std::invalid_argument("--attach and --processes exclude each other");
+    if (std::accumulate(TPCC::mix.begin(), TPCC::mix.end(), 0) == 0)
+      throw std::invalid_argument("--mix needs at least one positive weight");
+    thread_data.server_addr = argv[optind];
+    thread_data.port = std::stoi(argv[optind + 1]);
+    thread_count = std::stoi(argv[optind + 2]);
+    run_seconds = std::stoi(argv[optind + 3]);
+    message.insert(message.begin(), std::stoi(argv[optind + 4]), 'a');
     thread_data.message = &message;
   } catch (const std::exception& e) {
     std::cerr << e.what() << '\n';
-    std::cout << "Usage: " << argv[0] << " <ip address> <port> <number of threads> <testing time in s> <packet size in byte>" << std::endl;
+    printUsage(argv[0]);
     return 1;
   }
 
+  // a coordinator forks or accepts its workers before any thread exists, forked workers continue below
+  int coordinator_fd = attach_path ? Coordinator::attach(attach_path) : -1;
+  std::vector<int> worker_fds;
+  if (process_count > 0) {
+    if (workers_path)
+      worker_fds = Coordinator::acceptWorkers(workers_path, process_count);
+    else
+      coordinator_fd = Coordinator::forkWorkers(process_count, worker_fds);
+  }
+  if (!worker_fds.empty())
+    return coordinate(worker_fds, warmup_seconds, run_seconds, thread_data.connect_storm, thread_data.closed_loop);
+
   // start threads
+  thread_data.latencies.reset(new ThreadLatency[thread_count]);
+  thread_data.warehouse_counts.reset(new std::atomic<uint64_t>[TPCC::warehouseCount]());
+  thread_data.thread_count = thread_count;
   std::vector<std::thread> threads;
   for (int t_i = 0; t_i < thread_count; t_i++) {
-    threads.emplace_back(runThread, std::ref(thread_data));
+    threads.emplace_back(runThread, std::ref(thread_data), t_i);
   }
 
-  for (;;) {
-    sleep(10000);
-  }
+  if (coordinator_fd != -1) {
+    // worker: the coordinator opens and closes the measurement window
+    while (thread_data.started < thread_count)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    Coordinator::send(coordinator_fd, Coordinator::Command::ready);
+    Coordinator::expect(coordinator_fd, Coordinator::Command::start);
+    Report begin = snapshot(thread_data);
+    openWindow(thread_data);
+    Coordinator::expect(coordinator_fd, Coordinator::Command::stop);
+    Stats::Histogram latency = closeWindow(thread_data);
+    Report report = difference(snapshot(thread_data), begin);
+    report.latency = latency;
+    report.send(coordinator_fd);
+  } else {
+    // report answered and rejected requests every interval, measure from the end of the warmup to the end of the run
+    auto startTime = std::chrono::steady_clock::now();
+    auto windowStart = startTime + std::chrono::seconds(warmup_seconds);
+    auto windowEnd = windowStart + std::chrono::seconds(run_seconds);
+    bool windowOpen = false;
+    Report windowBegin;
+    Report last = snapshot(thread_data);
+    auto lastTime = startTime;
+    for (;;) {
+      auto now = std::chrono::steady_clock::now();
+      auto next = std::min(lastTime + REPORT_INTERVAL, windowOpen ? windowEnd : windowStart);
+      std::this_thread::sleep_until(next);
+      now = std::chrono::steady_clock::now();
 
-  /*
-  sleep(SETUP_TIME);
-  // start counting events
-  thread_data.count_events = true;
-  sleep(run_seconds);
+      if (!windowOpen && now >= windowStart) {
+        windowBegin = snapshot(thread_data);
+        openWindow(thread_data);
+        windowOpen = true;
+      } else if (windowOpen && now >= windowEnd) {
+        Stats::Histogram latency = closeWindow(thread_data);
+        Report report = difference(snapshot(thread_data), windowBegin);
+        report.latency = latency;
+        printSummary(report, std::chrono::duration<double, std::milli>(now - windowStart).count(), thread_data.connect_storm,
+                     thread_data.closed_loop);
+        break;
+      }
+      if (now < lastTime + REPORT_INTERVAL)
+        continue;
+
+      Report current = snapshot(thread_data);
+      Report interval = difference(current, last);
+      std::chrono::duration<double, std::milli> mSec = now - lastTime;
+      last = current;
+      lastTime = now;
+      std::cout << interval.events << " " << mSec.count() << " " << interval.events * 1000 / mSec.count() << " " << interval.busy;
+      if (thread_data.connect_storm)
+        std::cout << " " << interval.connects * 1000 / mSec.count();
+      if (thread_data.closed_loop) {
+        // round trip time percentiles in us
+        Stats::Histogram latency;
+        for (uint t_i = 0; t_i < thread_count; t_i++) {
+          std::lock_guard<std::mutex> guard(thread_data.latencies[t_i].latch);
+          latency.merge(thread_data.latencies[t_i].histogram);
+          thread_data.latencies[t_i].histogram.reset();
+        }
+        std::cout << " " << latency.percentile(0.5) / 1000.0 << " " << latency.percentile(0.99) / 1000.0 << " " << latency.max() / 1000.0;
+      }
+      std::cout << std::endl;
+      printWarehouses(interval, mSec.count());
+    }
+  }
 
   // stop threads
   thread_data.keep_running = false;
   for (auto& thread : threads) {
     thread.join();
   }
-
-  std::cout << "events\tseconds\tevents/s\tms/event\n"
-            << thread_data.event_count << "\t" << run_seconds << "\t" << (thread_data.event_count * 1.0) / run_seconds << "\t"
-            << (run_seconds * 1000.0) / thread_data.event_count << "\t" << std::endl;
-  */
   return 0;
 }
@@ -0,0 +1,22 @@
+#include "AdmissionControl.hpp"
+
+#include <algorithm>
+
+namespace TPCC
+{
+std::atomic<uint64_t> rejectedCounter = 0;
+
+void AdmissionControl::update(std::chrono::nanoseconds delay, size_t queueDepth)
+{
+  if (!config.enabled)
+    return;
+
+  // alpha = 1/8
+  smoothedDelay = smoothedDelay - smoothedDelay / 8 + static_cast<uint64_t>(delay.count()) / 8;
+
+  uint64_t target = std::chrono::nanoseconds(config.targetDelay).count();
+  uint64_t delayLevel = target ? smoothedDelay / target : 0;
+  uint64_t depthLevel = config.targetQueueDepth ? queueDepth / config.targetQueueDepth : 0;
+  level = std::min<uint64_t>(MAX_OVERLOAD_LEVEL, std::max(delayLevel, depthLevel));
+}
+}  // namespace TPCC
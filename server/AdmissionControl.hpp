@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "TPCCParser.hpp"
+
+namespace TPCC
+{
+extern std::atomic<uint64_t> rejectedCounter;
+
+inline constexpr uint8_t MAX_OVERLOAD_LEVEL = 3;
+
+// per-thread admission control on the transaction dispatch path
+// the overload level is derived from the number of connections waiting in the ready list and from the smoothed time a
+// connection waited for its turn. A request is executed if the priority of its FunctionID is at least the current level,
+// otherwise it is answered with ResponseCode::busy right away.
+class AdmissionControl
+{
+ public:
+  struct Config {
+    bool enabled = true;
+    // waiting time per turn that raises the level to 1, n times this raises it to n, 0 = ignore waiting time
+    std::chrono::microseconds targetDelay{2000};
+    // ready list length that raises the level to 1, n times this raises it to n, 0 = ignore queue depth
+    size_t targetQueueDepth = 32;
+    // priority per FunctionID, indexed by its value
+    // read-only point lookups are cheap and stay admitted longest, delivery is the most expensive and goes first
+    std::array<uint8_t, 8> priorities = {
+        0,  // notSet
+        1,  // newOrder
+        0,  // delivery
+        2,  // stockLevel
+        3,  // orderStatusId
+        2,  // orderStatusName
+        1,  // paymentById
+        1   // paymentByName
+    };
+  };
+
+  AdmissionControl(const Config& config) : config(config) {}
+
+  // called at the start of every connection turn with the time the connection waited for it
+  void update(std::chrono::nanoseconds delay, size_t queueDepth);
+
+  bool admit(FunctionID funcID) const { return !config.enabled || config.priorities[static_cast<uint8_t>(funcID)] >= level; }
+
+  uint8_t getLevel() const { return level; }
+
+ private:
+  const Config& config;
+  // exponentially weighted moving average of the waiting time in ns
+  uint64_t smoothedDelay = 0;
+  uint8_t level = 0;
+};
+}  // namespace TPCC
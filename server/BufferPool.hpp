@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Sys/HugePages.hpp"
+
+// per-thread pool of fixed size byte buffers, carved from blocks of at least buffersPerBlock buffers
+// the first block is allocated up front, so reads normally never touch the heap. Blocks are huge page mappings, a
+// block holds as many buffers as fit into its pages.
+class BufferPool
+{
+ public:
+  BufferPool(size_t bufferSize, size_t buffersPerBlock = 16)
+      : bufferSize(bufferSize), buffersPerBlock(std::max(buffersPerBlock, Sys::HUGE_PAGE_SIZE / bufferSize))
+  {
+    grow();
+  }
+  ~BufferPool()
+  {
+    for (uint8_t* block : blocks)
+      Sys::unmapPages(block, bufferSize * buffersPerBlock);
+  }
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  uint8_t* acquire()
+  {
+    if (freeList.empty())
+      grow();
+    uint8_t* buf = freeList.back();
+    freeList.pop_back();
+    return buf;
+  }
+
+  void release(uint8_t* buf) { freeList.push_back(buf); }
+
+  size_t getBufferSize() const { return bufferSize; }
+
+ private:
+  const size_t bufferSize;
+  const size_t buffersPerBlock;
+  std::vector<uint8_t*> blocks;
+  std::vector<uint8_t*> freeList;
+
+  void grow()
+  {
+    uint8_t* block = blocks.emplace_back(static_cast<uint8_t*>(Sys::mapPages(bufferSize * buffersPerBlock)));
+    freeList.reserve(blocks.size() * buffersPerBlock);
+    for (size_t i = buffersPerBlock; i-- > 0;)
+      freeList.push_back(block + i * bufferSize);
+  }
+};
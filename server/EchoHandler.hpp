@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+
+#include "HandlerContext.hpp"
+#include "PacketProtocol.hpp"
+
+// sends every varint length prefixed packet back unchanged
+// runs next to TPC-C to measure the transport on its own, without request parsing and execution
+class EchoHandler
+{
+ public:
+  EchoHandler() : packets(Reply{this}) {}
+
+  void parse(const uint8_t* data, size_t length) { packets.receive(data, length); }
+  void reset() { packets.reset(); }
+  void attach(std::vector<uint8_t>& outBuffer, HandlerContext&) { this->outBuffer = &outBuffer; }
+
+ private:
+  struct Reply {
+    EchoHandler* handler;
+    void operator()(Net::ByteView packet) const
+    {
+      Net::appendMessage(*handler->outBuffer, packet.data, packet.size, Net::PrefixFormat::varint);
+    }
+  };
+
+  std::vector<uint8_t>* outBuffer = nullptr;
+  Net::PacketProtocol<Reply, Net::PrefixFormat::varint> packets;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+// storage for the coroutine frame of a connection handler, a member of the handler so restarting the coroutine of a
+// recycled connection does not allocate
+// a frame larger than Size, or one allocated while the slot is taken, comes from the heap. Frames record where they
+// came from in a header, because the promise's operator delete is not given the pool.
+template <size_t Size>
+class FramePool
+{
+ public:
+  FramePool() = default;
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  void* allocate(size_t size)
+  {
+    if (!used && size <= Size) {
+      used = true;
+      return frame(storage, this);
+    }
+    return frame(static_cast<unsigned char*>(::operator new(HEADER_SIZE + size)), nullptr);
+  }
+
+  static void deallocate(void* frame)
+  {
+    unsigned char* block = static_cast<unsigned char*>(frame) - HEADER_SIZE;
+    FramePool* pool = *reinterpret_cast<FramePool**>(block);
+    if (pool)
+      pool->used = false;
+    else
+      ::operator delete(block);
+  }
+
+ private:
+  // keeps the frame after it aligned like the block
+  static constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+  alignas(std::max_align_t) unsigned char storage[HEADER_SIZE + Size];
+  bool used = false;
+
+  static void* frame(unsigned char* block, FramePool* pool)
+  {
+    *reinterpret_cast<FramePool**>(block) = pool;
+    return block + HEADER_SIZE;
+  }
+};
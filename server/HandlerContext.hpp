@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+namespace TPCC
+{
+class AdmissionControl;
+class TransactionBatch;
+}
+
+// per-thread services a protocol handler is attached to together with the output buffer of its connection
+struct HandlerContext {
+  const TPCC::AdmissionControl& admission;
+  // TPC-C transactions of the thread's current epoll round, executed and answered at the end of the round
+  TPCC::TransactionBatch& batch;
+  // connection whose data is being parsed, set by the reactor before every turn
+  void* connection = nullptr;
+  // TPCC::nowNanos() when the read that returned the data being parsed completed, 0 if the batch doesn't time requests
+  uint64_t readTime = 0;
+};
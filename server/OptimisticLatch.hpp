@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// version latch for optimistic lock coupling
+// writers lock it exclusively, readers only read the version: it is odd while a writer holds the latch and advances
+// on every unlock, so a reader that sees the same even version before and after reading saw no write in between.
+// Readers never write the latch's cache line, a torn read is detected and repeated instead.
+class OptimisticLatch
+{
+ public:
+  void lock()
+  {
+    for (unsigned spins = 0;; spins++) {
+      uint64_t v = version.load(std::memory_order_relaxed);
+      if (!(v & 1) && version.compare_exchange_weak(v, v + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        // the odd version must be visible before any write of the holder, or a reader could validate a torn read
+        std::atomic_thread_fence(std::memory_order_release);
+        return;
+      }
+      backoff(spins);
+    }
+  }
+
+  void unlock() { version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // version to validate a read against, waits while a writer holds the latch
+  uint64_t readLock() const
+  {
+    for (unsigned spins = 0;; spins++) {
+      uint64_t v = version.load(std::memory_order_acquire);
+      if (!(v & 1))
+        return v;
+      backoff(spins);
+    }
+  }
+
+  // true if no writer locked the latch since readLock returned v, so everything read in between is consistent
+  bool validate(uint64_t v) const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load(std::memory_order_relaxed) == v;
+  }
+
+ private:
+  std::atomic<uint64_t> version{0};
+
+  // spin briefly, then give the holder a chance to run if it shares the core
+  static void backoff(unsigned spins)
+  {
+    if (spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      std::this_thread::yield();
+    }
+  }
+};
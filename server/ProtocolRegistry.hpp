@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "EchoHandler.hpp"
+#include "TPCCCoroutineParser.hpp"
+#include "TPCCParser.hpp"
+
+// protocols a listener can speak
+// a handler is any class with
+//   void parse(const uint8_t* data, size_t length);                   consume request bytes, append responses
+//   void reset();                                                      drop partial state of the previous connection
+//   void attach(std::vector<uint8_t>& outBuffer, HandlerContext&);    set where responses go
+// connections are templated on their handler, so parse is called directly and can be inlined into the read loop
+// to add a protocol, append it to Protocol, ProtocolHandlers and PROTOCOL_NAMES in the same position
+// tpcc-coroutine is tpcc decoded by TPCC::CoroutineParser instead of the TPCC::Parser state machine
+enum class Protocol : uint8_t { tpcc, echo, tpccCoroutine };
+
+using ProtocolHandlers = std::tuple<TPCC::Parser, EchoHandler, TPCC::CoroutineParser>;
+
+inline constexpr const char* PROTOCOL_NAMES[] = {"tpcc", "echo", "tpcc-coroutine"};
+
+inline constexpr size_t PROTOCOL_COUNT = std::tuple_size_v<ProtocolHandlers>;
+static_assert(PROTOCOL_COUNT == std::size(PROTOCOL_NAMES));
+
+template <Protocol protocol>
+using HandlerOf = std::tuple_element_t<static_cast<size_t>(protocol), ProtocolHandlers>;
+
+// Protocol of a handler type
+template <typename Handler, size_t I = 0>
+constexpr Protocol protocolOf()
+{
+  static_assert(I < PROTOCOL_COUNT, "handler is not registered");
+  if constexpr (std::is_same_v<Handler, std::tuple_element_t<I, ProtocolHandlers>>)
+    return static_cast<Protocol>(I);
+  else
+    return protocolOf<Handler, I + 1>();
+}
+
+// std::tuple<T<Handler>...> over all registered handlers, e.g. one connection slab per protocol
+template <template <typename> class T, typename Handlers = ProtocolHandlers>
+struct PerProtocolHelper;
+template <template <typename> class T, typename... Handlers>
+struct PerProtocolHelper<T, std::tuple<Handlers...>> {
+  using type = std::tuple<T<Handlers>...>;
+};
+template <template <typename> class T>
+using PerProtocol = typename PerProtocolHelper<T>::type;
+
+// call func with a null pointer of the handler type of protocol, the compiler turns the chain into a jump table
+// used once per event to pick the typed code path, everything below it is statically dispatched
+template <size_t I = 0, typename Func>
+void withHandler(Protocol protocol, Func&& func)
+{
+  if constexpr (I < PROTOCOL_COUNT) {
+    if (static_cast<size_t>(protocol) == I)
+      func(static_cast<std::tuple_element_t<I, ProtocolHandlers>*>(nullptr));
+    else
+      withHandler<I + 1>(protocol, std::forward<Func>(func));
+  }
+}
+
+inline Protocol parseProtocol(const std::string& name)
+{
+  for (size_t i = 0; i < PROTOCOL_COUNT; i++) {
+    if (name == PROTOCOL_NAMES[i])
+      return static_cast<Protocol>(i);
+  }
+  throw std::invalid_argument("unknown protocol " + name);
+}
@@ -1,210 +1,787 @@
 #include "Server.hpp"
 
+#include "Sys/Affinity.hpp"
+
+// epoll data of the shared memory listening socket and of the redo log's commit eventfd, checked before the tags
+static void* const SHM_LISTEN = reinterpret_cast<void*>(1);
+static void* const COMMIT_NOTIFY = reinterpret_cast<void*>(3);
+// the control socket of a shared memory connection is registered with the connection pointer with this bit set
+static constexpr uintptr_t CONTROL_TAG = 1;
+// TCP listening sockets are registered with the pointer to their Listener with this bit set
+static constexpr uintptr_t LISTENER_TAG = 2;
+static constexpr uintptr_t TAG_MASK = CONTROL_TAG | LISTENER_TAG;
+
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <string>
 
-Server::Connection::Connection(int fd) : fd(fd) {}
+// SIGUSR1 writes a snapshot, SIGINT and SIGTERM may write one before the server exits
+static sigset_t snapshotSignals()
+{
+  sigset_t signals;
+  sigemptyset(&signals);
+  for (int sig : {SIGUSR1, SIGINT, SIGTERM})
+    sigaddset(&signals, sig);
+  return signals;
+}
+
+template <typename Handler>
+void Server::Connection<Handler>::reset(int fd, HandlerContext& context)
+{
+  this->fd = fd;
+  epollEvents = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  ready = false;
+  handler.reset();
+  handler.attach(outBuffer, context);
+  outBuffer.clear();
+}
 
-/*void Server::Connection::MessageHandler::operator()(std::vector<uint8_t>& data) const
+void Server::ThreadContext::pushReady(ConnectionBase* connection)
 {
-  eventCounter++;
-}*/
+  connection->prevReady = readyTail;
+  connection->nextReady = nullptr;
+  connection->ready = true;
+  connection->readySince = std::chrono::steady_clock::now();
+  readyCount++;
+  if (readyTail)
+    readyTail->nextReady = connection;
+  else
+    readyHead = connection;
+  readyTail = connection;
+}
 
-Server::Server()
+Server::ConnectionBase* Server::ThreadContext::popReady()
 {
-  pthread_rwlock_init(&connLatch, NULL);
+  ConnectionBase* connection = readyHead;
+  removeReady(connection);
+  return connection;
 }
 
-Server::~Server()
+void Server::ThreadContext::removeReady(ConnectionBase* connection)
 {
-  pthread_rwlock_destroy(&connLatch);
+  if (connection->prevReady)
+    connection->prevReady->nextReady = connection->nextReady;
+  else
+    readyHead = connection->nextReady;
+  if (connection->nextReady)
+    connection->nextReady->prevReady = connection->prevReady;
+  else
+    readyTail = connection->prevReady;
+  connection->prevReady = connection->nextReady = nullptr;
+  connection->ready = false;
+  readyCount--;
 }
 
-void Server::run(int threadCount)
+void Server::run()
 {
-  for (int t_i = 0; t_i < threadCount; t_i++) {
-    threads.emplace_back(&Server::runThread, this);
+  for (int t_i = 0; t_i < config.threadCount; t_i++) {
+    threads.emplace_back(&Server::runThread, this, t_i);
   }
 
   // benchmark
+  auto intervalPhases = std::make_unique<TPCC::PhaseStats>();
+  Sys::PageFaults faults = Sys::pageFaults();
+  uint64_t misses = 0;
   for (;;) {
     auto startTime = std::chrono::high_resolution_clock::now();
     TPCC::eventCounter = 0;
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    TPCC::rejectedCounter = 0;
+    acceptCounter = 0;
+    waitUntil(std::chrono::steady_clock::now() + std::chrono::seconds(5));
     uint64_t events = TPCC::eventCounter;
+    uint64_t rejected = TPCC::rejectedCounter;
+    uint64_t accepts = acceptCounter;
     std::chrono::duration<double, std::milli> mSec = std::chrono::high_resolution_clock::now() - startTime;
-    std::cout << events << " " << mSec.count() << " " << events * 1000 / mSec.count() << "\n";
+    std::cout << events << " " << mSec.count() << " " << events * 1000 / mSec.count() << " " << rejected << " " << accepts * 1000 / mSec.count()
+              << "\n";
+
+    // result cache: hit rate and execution time saved per cached transaction type
+    static const char* const cachedNames[] = {"stock-level", "order-status"};
+    for (size_t f = 0; f < TPCC::CACHED_FUNCTION_COUNT; f++) {
+      if (!config.resultCache.enabled[f])
+        continue;
+      TPCC::CacheCounters& counters = TPCC::cacheCounters[f];
+      uint64_t hits = counters.hits.exchange(0);
+      uint64_t lookups = hits + counters.misses.exchange(0);
+      uint64_t savedNanos = counters.savedNanos.exchange(0);
+      std::cout << "cache " << cachedNames[f] << ": " << (lookups ? hits * 100.0 / lookups : 0.0) << "% of " << lookups << " hit, saved "
+                << savedNanos / 1e6 << " ms\n";
+    }
+
+    // read-only transactions that repeated their optimistic read or fell back to locking
+    uint64_t restarts = TPCC::optimisticRestarts.exchange(0);
+    uint64_t locks = TPCC::optimisticLocks.exchange(0);
+    if (restarts || locks)
+      std::cout << "optimistic reads: " << restarts << " restarts, " << locks << " locked\n";
+
+    // deferred Deliveries: executed in the interval, queue depth now and at most, queued -> executed p50/p99/max in ms
+    if (deliveries) {
+      TPCC::DeliveryQueue::Metrics metrics;
+      deliveries->moveMetrics(metrics);
+      std::cout << "deliveries: " << metrics.executed << " executed, depth " << metrics.depth << " (max " << metrics.maxDepth << "), lag "
+                << metrics.lag.percentile(0.5) / 1e6 << "/" << metrics.lag.percentile(0.99) / 1e6 << "/" << metrics.lag.max() / 1e6 << " ms\n";
+    }
+
+    // function: phase p50/p99/max in us, each thread's histograms are merged and reset
+    if (config.phaseStats) {
+      for (auto& stats : phaseStats)
+        stats->moveTo(*intervalPhases);
+      intervalPhases->print(std::cout);
+      intervalPhases = std::make_unique<TPCC::PhaseStats>();
+    }
+
+    // page faults of the process and dTLB misses of the reactor threads per second, per transaction
+    if (config.memoryStats) {
+      Sys::PageFaults intervalFaults = Sys::pageFaults();
+      double seconds = mSec.count() / 1000;
+      std::cout << "memory: " << (intervalFaults.minor - faults.minor) / seconds << " minor faults/s, " << (intervalFaults.major - faults.major) / seconds
+                << " major faults/s, ";
+      faults = intervalFaults;
+      bool counting = false;
+      uint64_t total = 0;
+      for (int t = 0; t < config.threadCount; t++) {
+        counting |= tlbMisses[t].isOpen();
+        total += tlbMisses[t].read();
+      }
+      if (counting)
+        std::cout << (total - misses) / seconds << " dTLB misses/s, " << (events ? (total - misses) / static_cast<double>(events) : 0.0) << " per tx\n";
+      else
+        std::cout << "dTLB misses unavailable\n";
+      misses = total;
+    }
   }
 }
 
-void Server::runThread()
+void Server::waitUntil(std::chrono::steady_clock::time_point end)
+{
+  if (config.snapshotPath.empty()) {
+    std::this_thread::sleep_until(end);
+    return;
+  }
+  // the snapshot signals are blocked in every thread, only this one takes them
+  sigset_t signals = snapshotSignals();
+  for (auto now = std::chrono::steady_clock::now(); now < end; now = std::chrono::steady_clock::now()) {
+    auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(end - now).count();
+    struct timespec timeout = {static_cast<time_t>(left / 1000000000), static_cast<long>(left % 1000000000)};
+    int sig = sigtimedwait(&signals, nullptr, &timeout);
+    if (sig == SIGUSR1) {
+      saveSnapshot();
+    } else if (sig == SIGINT || sig == SIGTERM) {
+      if (config.snapshotOnExit)
+        saveSnapshot();
+      exit(EXIT_SUCCESS);
+    }
+  }
+}
+
+void Server::saveSnapshot()
+{
+  // transactions stop while the tables are written, the snapshot contains exactly the ones up to the log's last LSN
+  auto saveStart = std::chrono::steady_clock::now();
+  database->lockAll();
+  uint64_t lsn = log ? log->getLastLsn() : 0;
+  database->save(config.snapshotPath, lsn);
+  database->unlockAll();
+  std::chrono::duration<double> saveTime = std::chrono::steady_clock::now() - saveStart;
+  std::cout << "wrote snapshot " << config.snapshotPath << " at LSN " << lsn << " in " << saveTime.count() << " s" << std::endl;
+}
+
+// bytes mapped with each page size and the page faults so far
+void Server::printMemory()
 {
+  static const char* const backingNames[] = {"hugetlb", "transparent", "4k"};
+  std::cout << "memory:";
+  for (size_t b = 0; b < Sys::PAGE_BACKING_COUNT; b++)
+    std::cout << " " << Sys::mappedBytes(static_cast<Sys::PageBacking>(b)) / (1 << 20) << " MB " << backingNames[b];
+  Sys::PageFaults faults = Sys::pageFaults();
+  std::cout << ", " << faults.minor << " minor and " << faults.major << " major page faults\n";
+}
+
+void Server::runThread(int threadIndex)
+{
+  // pin before any per-thread state is allocated, so buffers and connections are first touched on the local NUMA node
+  int core = -1;
+  if (!config.cores.empty()) {
+    core = config.cores[threadIndex % config.cores.size()];
+    Sys::pinThread(core);
+    std::cout << "thread " << threadIndex << ": core " << core << ", node " << Sys::numaNode(core) << "\n";
+  }
+
+  if (config.memoryStats)
+    tlbMisses[threadIndex].open(Sys::PerfCounter::Event::dataTlbMisses);
+
+  // the redo log signals commits on an eventfd, responses of modifying transactions wait for it
+  int commitFd = -1;
+  TPCC::LogWriter* logWriter = nullptr;
+  if (log) {
+    if ((commitFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+      perror("eventfd()");
+      exit(EXIT_FAILURE);
+    }
+    logWriter = &log->attach(commitFd);
+  }
+
+  ThreadContext context(config, *database, logWriter, phaseStats[threadIndex].get(), deliveries.get());
+  context.commitFd = commitFd;
+  for (size_t l = 0; l < config.listeners.size(); l++) {
+    const ListenerConfig& listener = config.listeners[l];
+    if (config.incomingCpu) {
+      // own listening socket in the SO_REUSEPORT group, the kernel prefers it for connections whose packets arrive on core
+      int fd = createListenSocket(listener.port);
+      if (setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &core, sizeof(core)) == -1) {
+        perror("setsockopt(SO_INCOMING_CPU)");
+        exit(EXIT_FAILURE);
+      }
+      context.listeners.push_back({fd, listener.protocol});
+    } else {
+      context.listeners.push_back({listenfds[l], listener.protocol});
+    }
+  }
+
+  // per-thread epoll instance, EPOLLEXCLUSIVE wakes only one of the threads for a new connection
+  if ((context.epfd = epoll_create1(0)) == -1) {
+    perror("epoll_create1()");
+    exit(EXIT_FAILURE);
+  }
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+  for (Listener& listener : context.listeners) {
+    ev.data.ptr = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(&listener) | LISTENER_TAG);
+    if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, listener.fd, &ev) == -1) {
+      perror("epoll_ctl()");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (shmListenfd != -1) {
+    ev.data.ptr = SHM_LISTEN;
+    if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, shmListenfd, &ev) == -1) {
+      perror("epoll_ctl()");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (context.commitFd != -1) {
+    ev.data.ptr = COMMIT_NOTIFY;
+    ev.events = EPOLLIN;
+    if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, context.commitFd, &ev) == -1) {
+      perror("epoll_ctl()");
+      exit(EXIT_FAILURE);
+    }
+  }
+
   // main loop
-  struct epoll_event ev, events[1];
-  Connection* connection;
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  ConnectionBase* connection;
+
+  // in busy polling mode the thread spins on epoll_wait until it has been idle for busyPollIdle
+  bool busyPoll = config.busyPollIdle.count() != 0;
+  auto lastActivity = std::chrono::steady_clock::now();
 
   for (;;) {
-    // wait for epoll events
+    // wait for epoll events, only poll if there are connections left in the ready list or the thread is spinning
+    int timeout = -1;
+    if (context.readyHead || (busyPoll && std::chrono::steady_clock::now() - lastActivity < config.busyPollIdle))
+      timeout = 0;
     int nfds;
-    if ((nfds = epoll_wait(epfd, events, 1, -1)) == -1) {
+    if ((nfds = epoll_wait(context.epfd, events, EPOLL_MAX_EVENTS, timeout)) == -1) {
+      if (errno == EINTR)
+        continue;
       perror("epoll_wait()");
       exit(EXIT_FAILURE);
     }
+    auto roundStart = std::chrono::steady_clock::now();
+    if (nfds != 0 || context.readyHead)
+      lastActivity = roundStart;
 
-    // event loop
+    // event loop, the protocol of a connection is resolved once per event and its handler is called statically below
     for (int i = 0; i < nfds; ++i) {
       ev = events[i];
-      if (ev.data.fd == listenfd) {
-        // new socket user detected, accept connection
-        struct sockaddr_in clientaddr;
-        socklen_t clilen = sizeof(clientaddr);
-        int connfd = accept(listenfd, (struct sockaddr*)&clientaddr, &clilen);
-        if (connfd == -1) {
-          if (errno = EAGAIN || errno == EWOULDBLOCK)
-            continue;
-
-          perror("accept()");
-          exit(EXIT_FAILURE);
-        }
-
-        // add connection to hashtable and epoll
-        pthread_rwlock_wrlock(&connLatch);
-        connections.try_emplace(connfd, connfd);
-        pthread_rwlock_unlock(&connLatch);
-
-        setNonBlocking(connfd);
-        ev.data.fd = connfd;
-        ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
-        if (epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev) == -1) {
-          perror("epoll_ctl()");
-          exit(EXIT_FAILURE);
-        }
-      } else if ((ev.events & EPOLLERR) || (ev.events & EPOLLHUP)) {
+      uintptr_t data = reinterpret_cast<uintptr_t>(ev.data.ptr);
+      if (ev.data.ptr == SHM_LISTEN) {
+        acceptShm(context);
+      } else if (ev.data.ptr == COMMIT_NOTIFY) {
+        eventfd_t value;
+        eventfd_read(context.commitFd, &value);
+        releaseResponses(context);
+      } else if (data & LISTENER_TAG) {
+        // new socket user detected, accept connections
+        acceptConnections(context, *reinterpret_cast<Listener*>(data & ~TAG_MASK));
+      } else if (data & CONTROL_TAG) {
+        // the client of a shared memory channel went away
+        connection = reinterpret_cast<ConnectionBase*>(data & ~TAG_MASK);
+        if (connection->fd != -1)
+          closeConnection(context, connection);
+      } else {
+        connection = static_cast<ConnectionBase*>(ev.data.ptr);
+        if (connection->fd == -1)
+          // closed earlier in this round
+          continue;
+        withHandler(connection->protocol, [&](auto* handler) {
+          using Handler = std::remove_pointer_t<decltype(handler)>;
+          handleEvent(context, static_cast<Connection<Handler>*>(connection), ev.events, roundStart);
+        });
+      }
+    }
+
+    // give every connection in the ready list one more turn, connections that exhaust their budget again go to the back
+    ConnectionBase* last = context.readyTail;
+    while (last) {
+      connection = context.popReady();
+      bool wasLast = connection == last;
+      context.admission.update(std::chrono::steady_clock::now() - connection->readySince, context.readyCount);
+      IOResult result = IOResult::done;
+      withHandler(connection->protocol, [&](auto* handler) {
+        using Handler = std::remove_pointer_t<decltype(handler)>;
+        result = readConnection(context, static_cast<Connection<Handler>*>(connection));
+      });
+      if (result == IOResult::pending)
+        context.pushReady(connection);
+      else if (result == IOResult::done)
+        rearm(context, connection);
+      if (wasLast)
+        break;
+    }
+
+    executeBatch(context);
+
+    for (ConnectionBase* closedConnection : context.closed) {
+      withHandler(closedConnection->protocol, [&](auto* handler) {
+        using Handler = std::remove_pointer_t<decltype(handler)>;
+        std::get<ConnectionSlab<Handler>>(context.connections).release(static_cast<Connection<Handler>*>(closedConnection));
+      });
+    }
+    context.closed.clear();
+  }
+}
+
+// accept up to acceptBatch pending connections, the listening socket is level triggered and reports the rest again
+void Server::acceptConnections(ThreadContext& context, const Listener& listener)
+{
+  for (int n = 0; n < config.acceptBatch; n++) {
+    int connfd = accept4(listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (connfd == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return;
+      if (errno == ECONNABORTED || errno == EINTR)
+        continue;
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        // out of resources, leave the rest in the backlog until connections are closed
+        perror("accept4()");
+        return;
+      }
+      perror("accept4()");
+      exit(EXIT_FAILURE);
+    }
+    acceptCounter++;
+
+    setSocketOptions(connfd);
+    withHandler(listener.protocol, [&](auto* handler) { acceptConnection<std::remove_pointer_t<decltype(handler)>>(context, connfd); });
+  }
+}
+
+// take connection state from the slab of the protocol and add the socket to epoll
+template <typename Handler>
+void Server::acceptConnection(ThreadContext& context, int socket)
+{
+  Connection<Handler>* connection = std::get<ConnectionSlab<Handler>>(context.connections).acquire();
+  connection->reset(socket, context.handlerContext);
+
+  struct epoll_event ev;
+  ev.data.ptr = static_cast<ConnectionBase*>(connection);
+  ev.events = connection->epollEvents;
+  if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, socket, &ev) == -1) {
+    perror("epoll_ctl()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+// set up shared memory channels for up to acceptBatch co-located TPC-C clients, like acceptConnections
+void Server::acceptShm(ThreadContext& context)
+{
+  for (int n = 0; n < config.acceptBatch; n++) {
+    int socket = accept4(shmListenfd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (socket == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return;
+      if (errno == ECONNABORTED || errno == EINTR)
+        continue;
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        // out of resources, leave the rest in the backlog until connections are closed
+        perror("accept4()");
+        return;
+      }
+      perror("accept4()");
+      exit(EXIT_FAILURE);
+    }
+
+    ConnectionSlab<TPCC::Parser>& slab = std::get<ConnectionSlab<TPCC::Parser>>(context.connections);
+    Connection<TPCC::Parser>* connection = slab.acquire();
+    if (!connection->channel.accept(socket, config.shmRingSize)) {
+      connection->channel.close();
+      slab.release(connection);
+      continue;
+    }
+    addShmConnection(context, connection);
+  }
+}
+
+// add the doorbell and the control socket of a channel whose handshake succeeded to epoll
+void Server::addShmConnection(ThreadContext& context, Connection<TPCC::Parser>* connection)
+{
+  connection->reset(connection->channel.doorbell(), context.handlerContext);
+
+  // data is announced on the doorbell, hangups on the control socket
+  struct epoll_event ev;
+  ev.data.ptr = static_cast<ConnectionBase*>(connection);
+  ev.events = connection->epollEvents;
+  if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, connection->fd, &ev) == -1) {
+    perror("epoll_ctl()");
+    exit(EXIT_FAILURE);
+  }
+  ev.data.ptr = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(static_cast<ConnectionBase*>(connection)) | CONTROL_TAG);
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+  if (epoll_ctl(context.epfd, EPOLL_CTL_ADD, connection->channel.controlSocket(), &ev) == -1) {
+    perror("epoll_ctl()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <typename Handler>
+void Server::handleEvent(ThreadContext& context, Connection<Handler>* connection, uint32_t events,
+                         std::chrono::steady_clock::time_point roundStart)
+{
+  if ((events & EPOLLERR) || (events & EPOLLHUP)) {
+    // client closed connection
+    closeConnection(context, connection);
+    return;
+  }
+
+  if ((events & EPOLLOUT) && writeConnection(context, connection) == IOResult::closed)
+    return;
+
+  if (events & EPOLLIN) {
+    // the connection waited for the events before it in this round
+    context.admission.update(std::chrono::steady_clock::now() - roundStart, context.readyCount);
+    IOResult result = readConnection(context, connection);
+    if (result == IOResult::closed)
+      return;
+    if (result == IOResult::pending) {
+      // stays disarmed until the ready list has drained the socket
+      context.pushReady(connection);
+      return;
+    }
+  }
+
+  rearm(context, connection);
+}
+
+// read data from socket until EAGAIN or until the read budget is used up
+template <typename Handler>
+Server::IOResult Server::readConnection(ThreadContext& context, Connection<Handler>* connection)
+{
+  if (connection->channel.isOpen())
+    return readChannel(context, connection);
+
+  uint8_t* buf = context.receiveBuffers.acquire();
+  context.handlerContext.connection = connection;
+  IOResult result = IOResult::done;
+  size_t budget = config.readBudget;
+  for (;;) {
+    size_t readSize = config.bufferSize;
+    if (config.readBudget != 0) {
+      if (budget == 0) {
+        result = IOResult::pending;
+        break;
+      }
+      readSize = std::min(readSize, budget);
+    }
+
+    ssize_t n = read(connection->fd, buf, readSize);
+    if (context.batch.timing())
+      context.handlerContext.readTime = TPCC::nowNanos();
+    if (n == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // all data read
+        break;
+      } else if (errno == ECONNRESET) {
         // client closed connection
-        closeConnection(ev.data.fd);
+        result = IOResult::closed;
+        break;
       } else {
-        if (ev.events & EPOLLOUT) {
-          // write from outBuffer
-          pthread_rwlock_rdlock(&connLatch);
-          connection = &connections.at(ev.data.fd);
-          pthread_rwlock_unlock(&connLatch);
-          auto& buf = connection->outBuffer;
-
-          for (;;) {
-            auto n = send(ev.data.fd, &buf[0], buf.size(), MSG_NOSIGNAL);
-            if (n == -1) {
-              if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // socket buffer full
-                break;
-              } else if (errno == ECONNRESET) {
-                // client closed connection
-                closeConnection(ev.data.fd);
-                // continue with the event loop
-                goto continue_event_loop;
-              } else {
-                perror("send()");
-                exit(EXIT_FAILURE);
-              }
-            } else if (n != buf.size()) {
-              // there's still some of the message left
-              buf.erase(buf.begin(), buf.begin() + n);
-              connection->epollEvents |= EPOLLOUT;
-            } else {
-              // complete message has been sent
-              buf.clear();
-              connection->epollEvents &= ~EPOLLOUT;
-              break;
-            }
-          }
-        }
-
-        if (ev.events & EPOLLIN) {
-          pthread_rwlock_rdlock(&connLatch);
-          connection = &connections.at(ev.data.fd);
-          pthread_rwlock_unlock(&connLatch);
-
-          // read all data from socket until EAGAIN
-          char buf[bufferSize];
-          for (;;) {
-            ssize_t n = read(ev.data.fd, buf, bufferSize);
-            if (n == -1) {
-              if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // all data read
-                break;
-              } else if (errno == ECONNRESET) {
-                // client closed connection
-                closeConnection(ev.data.fd);
-                // continue with the event loop
-                goto continue_event_loop;
-              } else {
-                perror("read()");
-                exit(EXIT_FAILURE);
-              }
-            } else if (n == 0) {
-              // client closed connection
-              closeConnection(ev.data.fd);
-              // continue with the event loop
-              goto continue_event_loop;
-            } else {
-              // forward buf to packet protocol handler
-              //              connection->packetizer.receive(reinterpret_cast<const uint8_t*>(buf), n);
-              connection->parser.parse(reinterpret_cast<uint8_t*>(buf), n);
-            }
-          }
-        }
-
-        // rearm socket
-        ev.events = connection->epollEvents;
-        if (epoll_ctl(epfd, EPOLL_CTL_MOD, ev.data.fd, &ev) == -1) {
-          perror("epoll_ctl()");
-          exit(EXIT_FAILURE);
-        }
+        perror("read()");
+        exit(EXIT_FAILURE);
       }
+    } else if (n == 0) {
+      // client closed connection
+      result = IOResult::closed;
+      break;
+    } else {
+      // forward buf to the protocol handler
+      connection->handler.parse(buf, n);
+      budget -= std::min(budget, static_cast<size_t>(n));
+    }
+  }
+  context.receiveBuffers.release(buf);
+
+  if (result == IOResult::closed) {
+    closeConnection(context, connection);
+    return result;
+  }
+  if (config.quickAck)
+    setQuickAck(connection->fd);
 
-    continue_event_loop:;
+  // send the responses of this turn right away
+  if (!connection->outBuffer.empty() && writeConnection(context, connection) == IOResult::closed)
+    return IOResult::closed;
+  return result;
+}
+
+// parse requests in place in the ring of a shared memory channel until it is empty or the read budget is used up
+template <typename Handler>
+Server::IOResult Server::readChannel(ThreadContext& context, Connection<Handler>* connection)
+{
+  Net::ShmChannel& channel = connection->channel;
+  channel.waitDoorbell();
+
+  size_t limit = config.readBudget ? config.readBudget : std::numeric_limits<size_t>::max();
+  context.handlerContext.connection = connection;
+  if (context.batch.timing())
+    context.handlerContext.readTime = TPCC::nowNanos();
+  size_t n = channel.drain([&](Net::ByteView data) { connection->handler.parse(data.data, data.size); }, limit);
+
+  IOResult result = IOResult::done;
+  if (n == limit && !channel.inRing().empty())
+    result = IOResult::pending;
+  else if (!channel.inRing().prepareConsumerWait())
+    // the client wrote more before it saw that we are about to sleep
+    result = IOResult::pending;
+
+  if (!connection->outBuffer.empty())
+    writeChannel(connection);
+  return result;
+}
+
+// execute the transactions of this round and send the responses that don't wait for the redo log
+void Server::executeBatch(ThreadContext& context)
+{
+  context.batch.execute();
+  releaseResponses(context);
+}
+
+// append the responses whose transactions are durable and send them
+void Server::releaseResponses(ThreadContext& context)
+{
+  context.batch.release(log ? log->getDurableLsn() : std::numeric_limits<uint64_t>::max());
+  for (void* owner : context.batch.getReleased()) {
+    ConnectionBase* connection = static_cast<ConnectionBase*>(owner);
+    // a connection with several responses is listed once per response, only the first visit has something to send
+    if (connection->fd == -1 || connection->outBuffer.empty())
+      continue;
+    if (writeConnection(context, connection) == IOResult::closed)
+      continue;
+    // a full socket needs EPOLLOUT, a connection in the ready list gets it when it is rearmed after leaving the list
+    if ((connection->epollEvents & EPOLLOUT) && !connection->ready)
+      rearm(context, connection);
+  }
+  context.batch.getReleased().clear();
+}
+
+// write from outBuffer until it is empty or the socket buffer is full
+Server::IOResult Server::writeConnection(ThreadContext& context, ConnectionBase* connection)
+{
+  if (connection->channel.isOpen())
+    return writeChannel(connection);
+
+  auto& buf = connection->outBuffer;
+
+  for (;;) {
+    auto n = send(connection->fd, &buf[0], buf.size(), MSG_NOSIGNAL);
+    if (n == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // socket buffer full
+        connection->epollEvents |= EPOLLOUT;
+        return IOResult::done;
+      } else if (errno == ECONNRESET || errno == EPIPE) {
+        // client closed connection
+        closeConnection(context, connection);
+        return IOResult::closed;
+      } else {
+        perror("send()");
+        exit(EXIT_FAILURE);
+      }
+    } else if (n != buf.size()) {
+      // there's still some of the message left
+      buf.erase(buf.begin(), buf.begin() + n);
+      connection->epollEvents |= EPOLLOUT;
+    } else {
+      // complete message has been sent
+      buf.clear();
+      connection->epollEvents &= ~EPOLLOUT;
+      return IOResult::done;
     }
   }
 }
 
-// init epoll and listening socket
-void Server::init(uint16_t port, size_t bufferSize)
+// write from outBuffer into the ring of a shared memory channel, if it is full the client rings when it made space
+Server::IOResult Server::writeChannel(ConnectionBase* connection)
 {
-  this->bufferSize = bufferSize;
+  Net::ShmChannel& channel = connection->channel;
+  auto& buf = connection->outBuffer;
+  Net::ShmRing& ring = channel.outRing();
 
-  // epoll instance
-  if ((epfd = epoll_create(256)) == -1) {
-    perror("epoll_create()");
+  size_t written = 0;
+  for (;;) {
+    written += ring.write(&buf[written], buf.size() - written);
+    if (written == buf.size() || ring.prepareProducerWait())
+      break;
+  }
+  buf.erase(buf.begin(), buf.begin() + written);
+  if (written != 0 && ring.takeConsumerWaiting())
+    channel.ring();
+  return IOResult::done;
+}
+
+void Server::rearm(ThreadContext& context, ConnectionBase* connection)
+{
+  struct epoll_event ev;
+  ev.data.ptr = connection;
+  ev.events = connection->epollEvents;
+  if (epoll_ctl(context.epfd, EPOLL_CTL_MOD, connection->fd, &ev) == -1) {
+    perror("epoll_ctl()");
     exit(EXIT_FAILURE);
   }
+}
+
+// init listening socket, the epoll instances are created by the threads
+void Server::init(const Config& config)
+{
+  this->config = config;
+  // before the first table is allocated
+  Sys::setHugePagePolicy(config.hugePages);
+  database = std::make_unique<TPCC::Database>(config.warehouseCount);
+  if (!config.snapshotPath.empty()) {
+    // blocked before any other thread exists, so they all inherit the mask and waitUntil takes the signals
+    sigset_t signals = snapshotSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  }
+  auto loadStart = std::chrono::steady_clock::now();
+  if (!config.snapshotPath.empty() && database->load(config.snapshotPath)) {
+    std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "mapped " << database->getSnapshotSize() / (1 << 20) << " MB snapshot " << config.snapshotPath << " of " << config.warehouseCount
+              << " warehouses at LSN " << database->getSnapshotLsn() << " in " << loadTime.count() << " s\n";
+  } else {
+    std::vector<TPCC::TableLoad> loads = database->populate(config.loadThreads);
+    std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "populated " << config.warehouseCount << " warehouses in " << loadTime.count() << " s\n";
+    // rows per second of a single loader thread
+    for (const TPCC::TableLoad& load : loads)
+      std::cout << "  " << load.name << ": " << load.rows << " rows, " << (load.seconds > 0 ? load.rows / load.seconds : 0.0) << " rows/s\n";
+    // the initial population, before the log is replayed, so every run from this snapshot starts from the same state
+    if (!config.snapshotPath.empty())
+      saveSnapshot();
+  }
+  printMemory();
+  phaseStats.resize(config.threadCount);
+  tlbMisses = std::make_unique<Sys::PerfCounter[]>(config.threadCount);
+  if (config.phaseStats) {
+    for (auto& stats : phaseStats)
+      stats = std::make_unique<TPCC::PhaseStats>();
+  }
+  if (!config.logPath.empty()) {
+    log = std::make_unique<TPCC::RedoLog>(config.logPath);
+    auto recoveryStart = std::chrono::steady_clock::now();
+    size_t replayed = log->recover(*database);
+    std::chrono::duration<double> recoveryTime = std::chrono::steady_clock::now() - recoveryStart;
+    std::cout << "replayed " << replayed << " transactions from " << config.logPath << " in " << recoveryTime.count() << " s\n";
+    log->start();
+  }
+  if (config.deliveryQueueSize != 0) {
+    // nobody waits for the worker's commits, the Deliveries were answered when they were queued
+    deliveries = std::make_unique<TPCC::DeliveryQueue>(*database, log ? &log->attach(-1) : nullptr, config.deliveryQueueSize);
+    deliveries->start();
+  }
+  if (config.incomingCpu && config.cores.empty()) {
+    std::cerr << "steering connections by incoming cpu requires a core list\n";
+    exit(EXIT_FAILURE);
+  }
+
+  // with incoming cpu steering every thread listens on its own sockets
+  if (!config.incomingCpu) {
+    for (const ListenerConfig& listener : config.listeners)
+      listenfds.push_back(createListenSocket(listener.port));
+  }
+  if (!config.shmPath.empty())
+    shmListenfd = createShmListenSocket();
+}
+
+int Server::createShmListenSocket()
+{
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (config.shmPath.size() >= sizeof(address.sun_path)) {
+    std::cerr << "shm socket path too long\n";
+    exit(EXIT_FAILURE);
+  }
+  strcpy(address.sun_path, config.shmPath.c_str());
+
+  int fd;
+  if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+    perror("socket()");
+    exit(EXIT_FAILURE);
+  }
+  // remove the socket file of a previous run
+  unlink(address.sun_path);
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    perror("bind()");
+    exit(EXIT_FAILURE);
+  }
+  if (listen(fd, config.listenBacklog) == -1) {
+    perror("listen()");
+    exit(EXIT_FAILURE);
+  }
+  return fd;
+}
+
+int Server::createListenSocket(uint16_t port)
+{
+  int fd;
 
   // create socket
-  if ((listenfd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+  if ((fd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
     perror("socket()");
     exit(EXIT_FAILURE);
   }
-  setNonBlocking(listenfd);
+  setNonBlocking(fd);
 
   // allow immediate address reuse on restart
   // NOTE: tcp pakets from a previous run could still be pending
   int enable = 1;
-  if (setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1) {
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1) {
     perror("setsockopt()");
     exit(EXIT_FAILURE);
   }
-
-  // register listening socket
-  struct epoll_event ev;
-  memset(&ev, 0, sizeof(ev));
-  ev.data.fd = listenfd;
-  ev.events = EPOLLIN | EPOLLEXCLUSIVE;
-
-  if (epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) == -1) {
-    perror("epoll_ctl()");
+  if (config.incomingCpu && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1) {
+    perror("setsockopt(SO_REUSEPORT)");
+    exit(EXIT_FAILURE);
+  }
+  // accepted sockets inherit the buffer sizes, they have to be set before listen() to take effect on the window scale
+  if (config.receiveBufferSize && setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config.receiveBufferSize, sizeof(int)) == -1) {
+    perror("setsockopt(SO_RCVBUF)");
+    exit(EXIT_FAILURE);
+  }
+  if (config.sendBufferSize && setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &config.sendBufferSize, sizeof(int)) == -1) {
+    perror("setsockopt(SO_SNDBUF)");
     exit(EXIT_FAILURE);
   }
 
@@ -213,15 +790,15 @@ void Server::init(uint16_t port, size_t bufferSize)
   serveraddr.sin_family = AF_INET;
   serveraddr.sin_addr.s_addr = htonl(INADDR_ANY);
   serveraddr.sin_port = htons(port);
-  if (bind(listenfd, (struct sockaddr*)&serveraddr, sizeof(serveraddr)) == -1) {
+  if (bind(fd, (struct sockaddr*)&serveraddr, sizeof(serveraddr)) == -1) {
     perror("bind()");
     exit(EXIT_FAILURE);
   }
-  setNonBlocking(listenfd);
-  if (listen(listenfd, LISTEN_QUEUE_SIZE) == -1) {
+  if (listen(fd, config.listenBacklog) == -1) {
     perror("listen()");
     exit(EXIT_FAILURE);
   }
+  return fd;
 }
 
 // set socket to non-blocking
@@ -239,10 +816,52 @@ void Server::setNonBlocking(int socket)
   }
 }
 
-void Server::closeConnection(int fd)
+void Server::setSocketOptions(int socket)
+{
+  int enable = 1;
+  if (config.noDelay && setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) == -1) {
+    perror("setsockopt(TCP_NODELAY)");
+    exit(EXIT_FAILURE);
+  }
+  if (config.quickAck)
+    setQuickAck(socket);
+  if (config.socketBusyPoll)
+    setBusyPoll(socket);
+}
+
+// TCP_QUICKACK is not permanent, the kernel may fall back to delayed acks, so it is set again after every read turn
+void Server::setQuickAck(int socket)
+{
+  int enable = 1;
+  if (setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &enable, sizeof(enable)) == -1) {
+    perror("setsockopt(TCP_QUICKACK)");
+    exit(EXIT_FAILURE);
+  }
+}
+
+// let the kernel busy poll the device queue of the socket instead of waiting for the interrupt
+void Server::setBusyPoll(int socket)
+{
+  int usecs = config.socketBusyPoll;
+  int enable = 1;
+  if (setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) == -1 ||
+      setsockopt(socket, SOL_SOCKET, SO_PREFER_BUSY_POLL, &enable, sizeof(enable)) == -1) {
+    perror("setsockopt(SO_BUSY_POLL)");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void Server::closeConnection(ThreadContext& context, ConnectionBase* connection)
 {
-  pthread_rwlock_wrlock(&connLatch);
-  connections.erase(fd);
-  pthread_rwlock_unlock(&connLatch);
-  close(fd);
+  // closing the fds also removes them from epoll
+  if (connection->channel.isOpen())
+    connection->channel.close();
+  else
+    close(connection->fd);
+  connection->fd = -1;
+  // it goes back to the slab at the end of the round, the ready list must not reach it after that
+  if (connection->ready)
+    context.removeReady(connection);
+  context.closed.push_back(connection);
+  context.batch.forget(connection);
 }
@@ -1,45 +1,215 @@
 #pragma once
 #include <sys/epoll.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
-#include "TPCCParser.hpp"
+#include "AdmissionControl.hpp"
+#include "BufferPool.hpp"
+#include "ShmChannel.hpp"
+#include "HandlerContext.hpp"
+#include "ProtocolRegistry.hpp"
+#include "Slab.hpp"
+#include "TPCCBatch.hpp"
+#include "TPCCDatabase.hpp"
+#include "TPCCDeliveryQueue.hpp"
+#include "TPCCLog.hpp"
+#include "TPCCPhaseStats.hpp"
+#include "Sys/HugePages.hpp"
+#include "Sys/PerfCounter.hpp"
 
-inline constexpr int LISTEN_QUEUE_SIZE = 20;
+inline constexpr int EPOLL_MAX_EVENTS = 64;
 
 class Server
 {
  public:
-  Server();
-  ~Server();
-  void init(uint16_t port, size_t bufferSize);
-  void run(int threadCount);
-  void runThread();
+  struct ListenerConfig {
+    uint16_t port;
+    Protocol protocol;
+  };
 
- private:
-  struct Connection {
-    /*    struct MessageHandler {
-          Connection& connection;
-          void operator()(std::vector<uint8_t>& data) const;
-        };*/
+  struct Config {
+    // TCP ports and the protocol spoken on each of them
+    std::vector<ListenerConfig> listeners;
+    int threadCount;
+    size_t bufferSize;
+    uint32_t warehouseCount = 1;
+    // threads populating the database, 0 = one per core
+    unsigned loadThreads = 0;
+    // transactions a thread collects across its connections before it executes them, 1 = execute each right away
+    size_t batchSize = 256;
+    // bytes read from a connection per turn before the thread moves on to its other connections, 0 = read until EAGAIN
+    size_t readBudget = 64 * 1024;
+    TPCC::AdmissionControl::Config admission;
+    // cores the reactor threads are pinned to round-robin, empty = no pinning
+    std::vector<int> cores;
+    // give every thread its own SO_REUSEPORT listening socket with SO_INCOMING_CPU set to its core,
+    // so connections are accepted by the thread on the core that handles their NIC queue
+    bool incomingCpu = false;
+    // spin on epoll_wait with a zero timeout and only block after the thread was idle this long, 0 = always block
+    std::chrono::microseconds busyPollIdle{0};
+    // SO_BUSY_POLL time in us set together with SO_PREFER_BUSY_POLL on accepted sockets, 0 = off
+    int socketBusyPoll = 0;
+    // redo log file of the modifying transactions, replayed at startup, empty = no durability
+    std::string logPath;
+    // snapshot the tables are mapped from at startup, written after populating if there is none and on SIGUSR1
+    std::string snapshotPath;
+    // also write the snapshot on SIGINT and SIGTERM before exiting
+    bool snapshotOnExit = false;
+    // answer Deliveries when they are queued and execute them on a background worker, grouped by warehouse
+    // at most this many wait, 0 = execute them in the reactor threads' batches
+    size_t deliveryQueueSize = 0;
+    // read-only transaction types whose results are cached per thread
+    TPCC::ResultCache::Config resultCache;
+    // per FunctionID histograms of where requests spend their time in the server, printed every interval
+    bool phaseStats = false;
+    // append the phase durations to every response
+    bool echoTiming = false;
+    // pages backing the tables and the receive buffers
+    Sys::HugePagePolicy hugePages = Sys::HugePagePolicy::transparent;
+    // page faults and dTLB misses of the reactor threads, printed every interval
+    bool memoryStats = false;
+    // Unix domain socket path on which co-located clients set up TPC-C shared memory channels, empty = off
+    std::string shmPath;
+    // capacity of each ring of a shared memory channel, power of two
+    size_t shmRingSize = 1 << 20;
+    // listen() backlog, capped by net.core.somaxconn
+    int listenBacklog = 4096;
+    // connections accepted per wakeup of the listening socket before the thread serves its other connections
+    int acceptBatch = 64;
+    // socket options of accepted connections, buffer sizes of 0 keep the kernel's autotuning
+    bool noDelay = true;
+    bool quickAck = false;
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+  };
 
-    Connection(int fd);
+  void init(const Config& config);
+  void run();
+  void runThread(int threadIndex);
 
+ private:
+  // protocol independent part of a connection, the ready list and the closed list link these
+  struct ConnectionBase {
+    // socket, or the doorbell eventfd if the connection is a shared memory channel
     int fd;
-    uint32_t epollEvents = EPOLLIN | EPOLLET | EPOLLONESHOT;
-    TPCC::Parser parser;
+    uint32_t epollEvents;
+    Protocol protocol;
+    // open if the client is connected through shared memory instead of TCP
+    Net::ShmChannel channel;
     std::vector<uint8_t> outBuffer;
+    // neighbours in the thread's ready list and when it was appended
+    ConnectionBase* prevReady;
+    ConnectionBase* nextReady;
+    std::chrono::steady_clock::time_point readySince;
+    bool ready;
+  };
+
+  template <typename Handler>
+  struct Connection : ConnectionBase {
+    Connection() { protocol = protocolOf<Handler>(); }
+
+    // prepare a recycled connection for a newly accepted socket
+    void reset(int fd, HandlerContext& context);
+
+    Handler handler;
+  };
+
+  template <typename Handler>
+  using ConnectionSlab = Slab<Connection<Handler>>;
+
+  struct Listener {
+    int fd;
+    Protocol protocol;
+  };
+
+  // state owned by a single reactor thread
+  // every thread has its own epoll instance, so a connection is only ever touched by the thread that accepted it
+  struct ThreadContext {
+    ThreadContext(const Config& config, TPCC::Database& database, TPCC::LogWriter* log, TPCC::PhaseStats* phaseStats,
+                  TPCC::DeliveryQueue* deliveries)
+        : receiveBuffers(config.bufferSize),
+          admission(config.admission),
+          batch(database, config.batchSize, log, config.resultCache, phaseStats, config.echoTiming, deliveries),
+          handlerContext{admission, batch}
+    {
+    }
+
+    int epfd;
+    // registered in epoll by address, not resized after that
+    std::vector<Listener> listeners;
+    PerProtocol<ConnectionSlab> connections;
+    BufferPool receiveBuffers;
+    // connections that used up their read budget and still have data in the socket, served round-robin
+    // they are not armed in epoll while they are in this list
+    ConnectionBase* readyHead = nullptr;
+    ConnectionBase* readyTail = nullptr;
+    size_t readyCount = 0;
+    TPCC::AdmissionControl admission;
+    TPCC::TransactionBatch batch;
+    HandlerContext handlerContext;
+    // eventfd the redo log thread signals commits on, -1 without log
+    int commitFd = -1;
+    // connections closed in this round, returned to the slab only after it because a shared memory connection may
+    // still have an event for its second fd in the current epoll batch
+    std::vector<ConnectionBase*> closed;
+
+    void pushReady(ConnectionBase* connection);
+    ConnectionBase* popReady();
+    // unlink a connection from anywhere in the ready list, e.g. when it is closed
+    void removeReady(ConnectionBase* connection);
+  };
+
+  enum class IOResult {
+    done,     // socket drained (read) or outBuffer flushed / socket full (write)
+    pending,  // read budget exhausted with data left in the socket
+    closed    // connection was closed
   };
 
-  int epfd;
-  int listenfd;
-  size_t bufferSize;
+  Config config;
+  // shared by all threads unless every thread listens on its own sockets
+  std::vector<int> listenfds;
+  int shmListenfd = -1;
   std::vector<std::thread> threads;
-  pthread_rwlock_t connLatch;
-  std::unordered_map<int, Connection> connections;
+  std::unique_ptr<TPCC::Database> database;
+  std::unique_ptr<TPCC::RedoLog> log;
+  // nullptr unless Deliveries are deferred, stopped before the log
+  std::unique_ptr<TPCC::DeliveryQueue> deliveries;
+  // one per thread, nullptr entries if phase stats are off
+  std::vector<std::unique_ptr<TPCC::PhaseStats>> phaseStats;
+  // one per thread, opened by the thread itself if memory stats are on
+  std::unique_ptr<Sys::PerfCounter[]> tlbMisses;
+  std::atomic<uint64_t> acceptCounter{0};
 
+  void printMemory();
+  // sleep until end, writing snapshots when asked to
+  void waitUntil(std::chrono::steady_clock::time_point end);
+  void saveSnapshot();
+  void acceptConnections(ThreadContext& context, const Listener& listener);
+  template <typename Handler>
+  void acceptConnection(ThreadContext& context, int socket);
+  void acceptShm(ThreadContext& context);
+  void addShmConnection(ThreadContext& context, Connection<TPCC::Parser>* connection);
+  template <typename Handler>
+  void handleEvent(ThreadContext& context, Connection<Handler>* connection, uint32_t events, std::chrono::steady_clock::time_point roundStart);
+  template <typename Handler>
+  IOResult readConnection(ThreadContext& context, Connection<Handler>* connection);
+  template <typename Handler>
+  IOResult readChannel(ThreadContext& context, Connection<Handler>* connection);
+  void executeBatch(ThreadContext& context);
+  void releaseResponses(ThreadContext& context);
+  IOResult writeConnection(ThreadContext& context, ConnectionBase* connection);
+  IOResult writeChannel(ConnectionBase* connection);
+  void rearm(ThreadContext& context, ConnectionBase* connection);
+  int createListenSocket(uint16_t port);
+  int createShmListenSocket();
   void setNonBlocking(int socket);
-  void closeConnection(int fd);
+  void setSocketOptions(int socket);
+  void setQuickAck(int socket);
+  void setBusyPoll(int socket);
+  void closeConnection(ThreadContext& context, ConnectionBase* connection);
 };
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// per-thread pool of T objects allocated in chunks of chunkSize
+// released objects stay constructed in the free list, so heap memory they own (vectors etc.) is reused by the next acquire
+template <typename T, size_t chunkSize = 64>
+class Slab
+{
+ public:
+  // return a recycled or newly constructed object, allocates only if all chunks are in use
+  T* acquire()
+  {
+    if (freeList.empty())
+      grow();
+    T* obj = freeList.back();
+    freeList.pop_back();
+    return obj;
+  }
+
+  void release(T* obj) { freeList.push_back(obj); }
+
+  size_t capacity() const { return chunks.size() * chunkSize; }
+  size_t size() const { return capacity() - freeList.size(); }
+
+ private:
+  std::vector<std::unique_ptr<T[]>> chunks;
+  std::vector<T*> freeList;
+
+  void grow()
+  {
+    T* chunk = chunks.emplace_back(new T[chunkSize]).get();
+    freeList.reserve(capacity());
+    // hand out objects in address order
+    for (size_t i = chunkSize; i-- > 0;)
+      freeList.push_back(&chunk[i]);
+  }
+};
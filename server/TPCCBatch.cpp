@@ -0,0 +1,198 @@
+#include "TPCCBatch.hpp"
+
+#include <endian.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "TPCCDeliveryQueue.hpp"
+#include "TPCCLog.hpp"
+
+namespace TPCC
+{
+TransactionBatch::TransactionBatch(Database& database, size_t maxSize, LogWriter* log, const ResultCache::Config& cache,
+                                   PhaseStats* phaseStats, bool echoTiming, DeliveryQueue* deliveries)
+    : executor(database, log, cache), maxSize(maxSize), log(log), phaseStats(phaseStats), echoTiming(echoTiming), deliveries(deliveries)
+{
+  transactions.reserve(maxSize);
+  order.reserve(maxSize);
+}
+
+void TransactionBatch::add(FunctionID funcID, const FunctionParams& params, const VectorParams& vParams, std::vector<uint8_t>& outBuffer, void* owner,
+                           uint64_t readTime, Framing framing)
+{
+  Transaction& transaction = transactions.emplace_back();
+  transaction.funcID = funcID;
+  transaction.code = ResponseCode::ok;
+  transaction.result = 0;
+  transaction.params = params;
+  transaction.firstLine = lines.size();
+  transaction.outBuffer = &outBuffer;
+  transaction.owner = owner;
+  transaction.framing = framing;
+  transaction.timing.read = readTime;
+  if (readTime != 0)
+    transaction.timing.parsed = nowNanos();
+  if (funcID == FunctionID::newOrder) {
+    for (size_t l = 0; l < params.newOrder.vecSize; l++) {
+      lines.push_back({static_cast<uint32_t>(vParams.supwares[l]), static_cast<uint32_t>(vParams.itemids[l]),
+                       static_cast<uint32_t>(vParams.qtys[l])});
+    }
+  }
+  if (transactions.size() >= maxSize)
+    execute();
+}
+
+void TransactionBatch::reject(FunctionID funcID, std::vector<uint8_t>& outBuffer, void* owner, uint64_t readTime, Framing framing)
+{
+  Transaction& transaction = transactions.emplace_back();
+  transaction.funcID = funcID;
+  transaction.code = ResponseCode::busy;
+  transaction.result = 0;
+  transaction.outBuffer = &outBuffer;
+  transaction.owner = owner;
+  transaction.framing = framing;
+  // never queued nor executed, its phases after parsing are empty
+  transaction.timing.read = readTime;
+  if (readTime != 0)
+    transaction.timing.parsed = transaction.timing.executionStart = transaction.timing.executionEnd = nowNanos();
+  if (transactions.size() >= maxSize)
+    execute();
+}
+
+void TransactionBatch::execute()
+{
+  if (transactions.empty())
+    return;
+
+  // a connection's request starts a new step when it must see the effects of its earlier ones: a different function
+  // after a write, or a write after a read. Steps run one after the other, so only independent requests are grouped.
+  order.clear();
+  steps.resize(transactions.size());
+  connections.clear();
+  for (size_t i = 0; i < transactions.size(); i++) {
+    Transaction& transaction = transactions[i];
+    auto [it, first] = connections.try_emplace(transaction.owner, ConnectionStep{0, transaction.funcID});
+    ConnectionStep& connection = it->second;
+    if (!first && transaction.funcID != connection.funcID &&
+        !(Executor::readOnly(transaction.funcID) && Executor::readOnly(connection.funcID)))
+      connection.step++;
+    connection.funcID = transaction.funcID;
+    steps[i] = connection.step;
+    if (transaction.code == ResponseCode::ok)
+      order.push_back(&transaction);
+  }
+  auto step = [&](const Transaction* transaction) { return steps[transaction - transactions.data()]; };
+  std::stable_sort(order.begin(), order.end(), [&](const Transaction* a, const Transaction* b) {
+    if (step(a) != step(b))
+      return step(a) < step(b);
+    if (a->funcID != b->funcID)
+      return a->funcID < b->funcID;
+    return Executor::homeWarehouse(*a) < Executor::homeWarehouse(*b);
+  });
+
+  for (size_t begin = 0; begin != order.size();) {
+    FunctionID funcID = order[begin]->funcID;
+    uint32_t w_id = Executor::homeWarehouse(*order[begin]);
+    size_t end = begin + 1;
+    while (end != order.size() && step(order[end]) == step(order[begin]) && order[end]->funcID == funcID &&
+           Executor::homeWarehouse(*order[end]) == w_id)
+      end++;
+    // deferred Deliveries are answered once they are queued, their execution is up to the delivery worker
+    auto run = [&]() {
+      if (funcID == FunctionID::delivery && deliveries)
+        deliveries->push(&order[begin], end - begin, log);
+      else
+        executor.run(funcID, &order[begin], end - begin, lines.data());
+    };
+    if (timing()) {
+      uint64_t start = nowNanos();
+      run();
+      uint64_t finish = nowNanos();
+      for (size_t i = begin; i < end; i++) {
+        order[i]->timing.executionStart = start;
+        order[i]->timing.executionEnd = finish;
+      }
+    } else {
+      run();
+    }
+    eventCounter += end - begin;
+    begin = end;
+  }
+
+  // every response of the batch waits for the last LSN handed out so far, read-only transactions included, because
+  // they may have read writes of this or other threads that are not durable yet
+  uint64_t lsn = log ? log->getLastLsn() : 0;
+  for (const Transaction& transaction : transactions) {
+    held.push_back({lsn, transaction.outBuffer, transaction.owner, transaction.funcID, transaction.code, transaction.result, transaction.timing,
+                    transaction.framing});
+  }
+  transactions.clear();
+  lines.clear();
+}
+
+void TransactionBatch::release(uint64_t durableLsn)
+{
+  // fan the results back out, a connection gets its responses in the order of its requests
+  uint64_t sent = timing() && !held.empty() && held.front().lsn <= durableLsn ? nowNanos() : 0;
+  while (!held.empty() && held.front().lsn <= durableLsn) {
+    HeldResponse& response = held.front();
+    PhaseStats::Durations durations{};
+    if (response.timing.read != 0) {
+      durations = PhaseStats::durations(response.timing, sent);
+      if (phaseStats && response.code != ResponseCode::busy)
+        phaseStats->record(response.funcID, durations);
+    }
+
+    if (response.outBuffer) {
+      size_t timingSize = echoTiming ? RESPONSE_TIMING_SIZE : 0;
+      uint8_t payload[RESPONSE_HEADER_SIZE + RESPONSE_RESULT_SIZE + RESPONSE_TIMING_SIZE] = {static_cast<uint8_t>(response.funcID),
+                                                                                             static_cast<uint8_t>(response.code)};
+      size_t size = RESPONSE_HEADER_SIZE;
+      // an entry of a response frame always has a result, so the client can step through the frame
+      if (response.code == ResponseCode::ok || response.framing.framed) {
+        uint32_t result = htobe32(response.code == ResponseCode::ok ? response.result : 0);
+        memcpy(payload + size, &result, RESPONSE_RESULT_SIZE);
+        size += RESPONSE_RESULT_SIZE;
+      }
+      if (echoTiming) {
+        for (size_t p = 0; p < RESPONSE_TIMING_SIZE / sizeof(uint32_t); p++) {
+          uint32_t nanos = htobe32(std::min<uint64_t>(durations[p], UINT32_MAX));
+          memcpy(payload + size, &nanos, sizeof(nanos));
+          size += sizeof(nanos);
+        }
+      }
+      // the first entry of a response frame writes the prefix and header of all of them, the others follow it in the
+      // connection's order
+      size_t frameLength = size;
+      if (response.framing.framed)
+        frameLength = response.framing.frameSize != 0 ? BATCH_HEADER_SIZE + response.framing.frameSize * (BATCH_ENTRY_SIZE + timingSize) : 0;
+      if (frameLength != 0) {
+        uint8_t prefix[Net::MAX_PREFIX_LENGTH + BATCH_HEADER_SIZE];
+        size_t prefixSize = Net::encodePrefix(prefix, frameLength, RESPONSE_PREFIX_FORMAT);
+        if (response.framing.framed) {
+          prefix[prefixSize++] = BATCH_FRAME_ID;
+          prefix[prefixSize++] = response.framing.frameSize;
+        }
+        response.outBuffer->insert(response.outBuffer->end(), prefix, prefix + prefixSize);
+      }
+      response.outBuffer->insert(response.outBuffer->end(), payload, payload + size);
+      released.push_back(response.owner);
+    }
+    held.pop_front();
+  }
+}
+
+void TransactionBatch::forget(void* owner)
+{
+  // its queued transactions still run, the client sent them
+  for (Transaction& transaction : transactions) {
+    if (transaction.owner == owner)
+      transaction.outBuffer = nullptr;
+  }
+  for (HeldResponse& response : held) {
+    if (response.owner == owner)
+      response.outBuffer = nullptr;
+  }
+}
+}  // namespace TPCC
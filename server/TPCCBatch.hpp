@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "TPCCExecutor.hpp"
+
+namespace TPCC
+{
+class DeliveryQueue;
+
+// transactions parsed by one reactor thread, collected across all of its connections during one epoll round
+// execute() runs them grouped by FunctionID and home warehouse, so the executor amortizes latching and row access
+// over a group, without reordering requests of one connection that depend on each other. The responses are held in
+// arrival order until the redo log records of their batch are durable, then release() appends them to the
+// connections' outBuffers and reports the connections to flush.
+// The responses of the requests of a batch frame are appended as the entries of one response frame, the first one
+// opens it (see Response.hpp).
+// With timing on, every transaction is timestamped from the read() that completed it to the release of its response,
+// the phase durations go to the thread's PhaseStats and optionally into the response (see Response.hpp).
+class TransactionBatch
+{
+ public:
+  // maxSize = 1 executes every transaction on its own as soon as it is parsed, log = nullptr = no redo log
+  // phaseStats = nullptr and echoTiming = false turn timing off, deliveries = nullptr executes Deliveries in the batch
+  TransactionBatch(Database& database, size_t maxSize, LogWriter* log, const ResultCache::Config& cache, PhaseStats* phaseStats,
+                   bool echoTiming, DeliveryQueue* deliveries);
+
+  bool timing() const { return phaseStats || echoTiming; }
+
+  // queue a transaction, the batch executes right away once it holds maxSize transactions
+  // readTime is the nowNanos() of the read() that completed the request, 0 if timing is off
+  void add(FunctionID funcID, const FunctionParams& params, const VectorParams& vParams, std::vector<uint8_t>& outBuffer, void* owner,
+           uint64_t readTime, Framing framing);
+  // queue the busy response of a transaction rejected by admission control, keeps the responses of a connection in order
+  void reject(FunctionID funcID, std::vector<uint8_t>& outBuffer, void* owner, uint64_t readTime, Framing framing);
+
+  void execute();
+  // append the held responses whose records are durable, their owners are collected in getReleased()
+  void release(uint64_t durableLsn);
+  // drop the responses of a closed connection
+  void forget(void* owner);
+
+  bool holding() const { return !held.empty(); }
+  std::vector<void*>& getReleased() { return released; }
+
+ private:
+  struct HeldResponse {
+    uint64_t lsn;
+    std::vector<uint8_t>* outBuffer;
+    void* owner;
+    FunctionID funcID;
+    ResponseCode code;
+    uint32_t result;
+    Timing timing;
+    Framing framing;
+  };
+
+  Executor executor;
+  size_t maxSize;
+  std::vector<Transaction> transactions;
+  std::vector<OrderLineRequest> lines;
+  struct ConnectionStep {
+    uint32_t step;
+    // of the connection's latest request
+    FunctionID funcID;
+  };
+
+  // transactions sorted by (step, FunctionID, home warehouse, arrival)
+  std::vector<Transaction*> order;
+  // step of every transaction, indexed like transactions
+  std::vector<uint32_t> steps;
+  std::unordered_map<void*, ConnectionStep> connections;
+  // responses in arrival order, a response is only released after all responses before it
+  std::deque<HeldResponse> held;
+  LogWriter* log;
+  std::vector<void*> released;
+  PhaseStats* phaseStats;
+  bool echoTiming;
+  DeliveryQueue* deliveries;
+};
+}  // namespace TPCC
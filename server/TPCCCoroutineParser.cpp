@@ -0,0 +1,171 @@
+#include "TPCCCoroutineParser.hpp"
+
+#include <algorithm>
+
+#include "AdmissionControl.hpp"
+#include "TPCCBatch.hpp"
+
+namespace TPCC
+{
+CoroutineParser::CoroutineParser()
+{
+  // vecSize is a single byte, so the vectors never have to grow beyond this
+  vParams.lineNumbers.reserve(UINT8_MAX);
+  vParams.supwares.reserve(UINT8_MAX);
+  vParams.itemids.reserve(UINT8_MAX);
+  vParams.qtys.reserve(UINT8_MAX);
+}
+
+CoroutineParser::~CoroutineParser()
+{
+  if (decoder.handle)
+    decoder.handle.destroy();
+}
+
+void CoroutineParser::reset()
+{
+  // the old frame goes back to the pool before the new one is taken from it
+  if (decoder.handle)
+    decoder.handle.destroy();
+  pendingLength = 0;
+  frame.reset();
+  decoder = decode();
+}
+
+void CoroutineParser::attach(std::vector<uint8_t>& outBuffer, HandlerContext& context)
+{
+  this->outBuffer = &outBuffer;
+  this->context = &context;
+}
+
+void CoroutineParser::parse(const uint8_t* data, size_t length)
+{
+  input = data;
+  inputEnd = data + length;
+  // complete the field the coroutine waits for, it runs until the input ends in the middle of another one
+  if (pendingLength != 0 && !take(pending, pendingLength))
+    return;
+  decoder.handle.resume();
+}
+
+bool CoroutineParser::take(uint8_t* dest, size_t length)
+{
+  size_t n = std::min<size_t>(length, inputEnd - input);
+  memcpy(dest, input, n);
+  input += n;
+  pending = dest + n;
+  pendingLength = length - n;
+  return pendingLength == 0;
+}
+
+void CoroutineParser::readVector(std::vector<int32_t>& dest, size_t size)
+{
+  dest.resize(size);
+  for (size_t i = 0; i < size; i++) {
+    uint32_t value;
+    memcpy(&value, vector + i * sizeof(value), sizeof(value));
+    dest[i] = static_cast<int32_t>(be32toh(value));
+  }
+}
+
+CoroutineParser::Decoder CoroutineParser::decode()
+{
+  for (;;) {
+    uint8_t id;
+    co_await read(&id, 1);
+    FunctionID funcID = static_cast<FunctionID>(id);
+    switch (funcID) {
+      case FunctionID::newOrder: {
+        FunctionParams::NewOrder& p = params.newOrder;
+        co_await read(&p.vecSize, 1);
+        co_await read(p.w_id);
+        co_await read(p.d_id);
+        co_await read(p.c_id);
+        // each vector is read at once, then converted
+        size_t vectorSize = p.vecSize * sizeof(int32_t);
+        co_await read(vector, vectorSize);
+        readVector(vParams.lineNumbers, p.vecSize);
+        co_await read(vector, vectorSize);
+        readVector(vParams.supwares, p.vecSize);
+        co_await read(vector, vectorSize);
+        readVector(vParams.itemids, p.vecSize);
+        co_await read(vector, vectorSize);
+        readVector(vParams.qtys, p.vecSize);
+        co_await read(p.timestamp);
+        break;
+      }
+      case FunctionID::delivery:
+        co_await read(params.delivery.w_id);
+        co_await read(params.delivery.carrier_id);
+        co_await read(params.delivery.datetime);
+        break;
+      case FunctionID::stockLevel:
+        co_await read(params.stockLevel.w_id);
+        co_await read(params.stockLevel.d_id);
+        co_await read(params.stockLevel.threshold);
+        break;
+      case FunctionID::orderStatusId:
+        co_await read(params.orderStatusId.w_id);
+        co_await read(params.orderStatusId.d_id);
+        co_await read(params.orderStatusId.c_id);
+        break;
+      case FunctionID::orderStatusName: {
+        FunctionParams::OrderStatusName& p = params.orderStatusName;
+        co_await read(&p.strLength, 1);
+        co_await read(p.w_id);
+        co_await read(p.d_id);
+        co_await read(name, p.strLength);
+        // a longer name is cut to c_last
+        std::fill(p.c_last, p.c_last + sizeof(p.c_last), 0);
+        memcpy(p.c_last, name, std::min<size_t>(p.strLength, sizeof(p.c_last)));
+        break;
+      }
+      case FunctionID::paymentById:
+        co_await read(params.paymentById.w_id);
+        co_await read(params.paymentById.d_id);
+        co_await read(params.paymentById.c_w_id);
+        co_await read(params.paymentById.c_d_id);
+        co_await read(params.paymentById.c_id);
+        co_await read(params.paymentById.h_date);
+        co_await read(params.paymentById.h_amount);
+        co_await read(params.paymentById.datetime);
+        break;
+      case FunctionID::paymentByName: {
+        FunctionParams::PaymentByName& p = params.paymentByName;
+        co_await read(&p.strLength, 1);
+        co_await read(p.w_id);
+        co_await read(p.d_id);
+        co_await read(p.c_w_id);
+        co_await read(p.c_d_id);
+        co_await read(name, p.strLength);
+        std::fill(p.c_last, p.c_last + sizeof(p.c_last), 0);
+        memcpy(p.c_last, name, std::min<size_t>(p.strLength, sizeof(p.c_last)));
+        co_await read(p.h_date);
+        co_await read(p.h_amount);
+        co_await read(p.datetime);
+        break;
+      }
+      case FunctionID::batch:
+        // the requests of the frame follow as usual
+        co_await read(&id, 1);
+        frame.open(id);
+        continue;
+      default:
+        // no function id, like Parser the byte is skipped
+        continue;
+    }
+    runTPCCFunction(funcID);
+  }
+}
+
+void CoroutineParser::runTPCCFunction(FunctionID funcID)
+{
+  Framing framing = frame.next();
+  if (!context->admission.admit(funcID)) {
+    rejectedCounter++;
+    context->batch.reject(funcID, *outBuffer, context->connection, context->readTime, framing);
+    return;
+  }
+  context->batch.add(funcID, params, vParams, *outBuffer, context->connection, context->readTime, framing);
+}
+}  // namespace TPCC
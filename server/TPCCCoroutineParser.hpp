@@ -0,0 +1,121 @@
+#pragma once
+#include <endian.h>
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include "FramePool.hpp"
+#include "HandlerContext.hpp"
+#include "TPCCParser.hpp"
+
+namespace TPCC
+{
+// decodes the same requests as Parser, written as a C++20 coroutine instead of a state machine
+// every connection runs one coroutine that reads request after request as straight-line code. It suspends only when
+// the bytes handed to parse() run out in the middle of a field and is resumed by the next parse() once the field is
+// complete, so a field is converted once instead of being shifted together byte by byte. Its frame lives in the
+// handler (see FramePool), connections are recycled by their slab, so decoding never allocates.
+// Complete requests go to the admission control and batch of the thread like the ones of Parser.
+class CoroutineParser
+{
+ public:
+  CoroutineParser();
+  ~CoroutineParser();
+  CoroutineParser(const CoroutineParser&) = delete;
+  CoroutineParser& operator=(const CoroutineParser&) = delete;
+
+  void parse(const uint8_t* data, size_t length);
+  // restart the coroutine, dropping any partially read paket
+  void reset();
+  void attach(std::vector<uint8_t>& outBuffer, HandlerContext& context);
+
+ private:
+  struct Decoder {
+    struct promise_type {
+      // started by the first parse()
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      Decoder get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+
+      // the frame of decode() is allocated from the pool of the parser it is called on
+      static void* operator new(size_t size, CoroutineParser& parser)
+      {
+        assert(size <= FRAME_SIZE);
+        return parser.frames.allocate(size);
+      }
+      static void operator delete(void* frame) { FramePool<FRAME_SIZE>::deallocate(frame); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  // awaits length bytes at dest
+  struct ReadBytes {
+    CoroutineParser& parser;
+    uint8_t* dest;
+    size_t length;
+
+    bool await_ready() { return parser.take(dest, length); }
+    void await_suspend(std::coroutine_handle<>) {}
+    void await_resume() {}
+  };
+
+  // awaits a big endian integer, its bytes are collected in the parser to keep the frame small
+  template <typename T>
+  struct ReadInteger {
+    CoroutineParser& parser;
+    T& dest;
+
+    bool await_ready() { return parser.take(parser.field, sizeof(T)); }
+    void await_suspend(std::coroutine_handle<>) {}
+    void await_resume()
+    {
+      T value;
+      memcpy(&value, parser.field, sizeof(T));
+      if constexpr (sizeof(T) == sizeof(uint64_t))
+        dest = be64toh(value);
+      else
+        dest = be32toh(value);
+    }
+  };
+
+  // sized for the frame of decode() with some room for other compilers, checked by the assert above
+  static constexpr size_t FRAME_SIZE = 1024;
+
+  FramePool<FRAME_SIZE> frames;
+  Decoder decoder;
+  // unread part of the data of the current parse()
+  const uint8_t* input = nullptr;
+  const uint8_t* inputEnd = nullptr;
+  // bytes the suspended coroutine still waits for
+  uint8_t* pending = nullptr;
+  size_t pendingLength = 0;
+  uint8_t field[sizeof(uint64_t)];
+
+  FunctionParams params;
+  VectorParams vParams;
+  BatchFrame frame;
+  // a vector of a NewOrder as it is on the wire, vecSize is a single byte
+  uint8_t vector[UINT8_MAX * sizeof(int32_t)];
+  // c_last of an OrderStatusName or PaymentByName, strLength is a single byte
+  uint8_t name[UINT8_MAX];
+  std::vector<uint8_t>* outBuffer = nullptr;
+  HandlerContext* context = nullptr;
+
+  Decoder decode();
+  // copy as much of length bytes to dest as the input holds, false if the rest is pending
+  bool take(uint8_t* dest, size_t length);
+  ReadBytes read(uint8_t* dest, size_t length) { return {*this, dest, length}; }
+  ReadInteger<uint32_t> read(uint32_t& dest) { return {*this, dest}; }
+  ReadInteger<uint64_t> read(uint64_t& dest) { return {*this, dest}; }
+  void readVector(std::vector<int32_t>& dest, size_t size);
+  void runTPCCFunction(FunctionID funcID);
+};
+}  // namespace TPCC
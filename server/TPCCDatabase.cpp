@@ -0,0 +1,310 @@
+#include "TPCCDatabase.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+#include "TPCC/Random.hpp"
+
+namespace TPCC
+{
+namespace
+{
+// tables populate reports on, NEW-ORDER has no rows of its own
+enum class Loaded { item, warehouse, stock, district, customer, history, order, orderLine };
+constexpr size_t LOADED_COUNT = 8;
+const char* const loadedNames[] = {"item", "warehouse", "stock", "district", "customer", "history", "order", "order-line"};
+
+// zero padded copy of a generated string into a fixed size column
+template <size_t size, int maxLength>
+void copy(char (&column)[size], const Varchar<maxLength>& value)
+{
+  static_assert(maxLength <= static_cast<int>(size), "column too short");
+  memcpy(column, value.data, value.length);
+  std::fill(column + value.length, column + size, 0);
+}
+
+// i_data and s_data, 10% contain "ORIGINAL" at a random position
+void data(char (&column)[50])
+{
+  copy(column, randomastring<50>(26, 50));
+  if (urand(1, 10) == 1)
+    memcpy(column + urand(0, strnlen(column, sizeof(column)) - 8), "ORIGINAL", 8);
+}
+
+template <typename Row>
+void address(Row& row)
+{
+  copy(row.street1, randomastring<20>(10, 20));
+  copy(row.street2, randomastring<20>(10, 20));
+  copy(row.city, randomastring<20>(10, 20));
+  copy(row.state, randomastring<2>(2, 2));
+  copy(row.zip, randomzip());
+}
+
+// seeds of the tasks of populate, distinct for the items, every warehouse and every district
+uint64_t itemSeed()
+{
+  return 0;
+}
+uint64_t warehouseSeed(uint32_t w_id)
+{
+  return static_cast<uint64_t>(w_id) * (DISTRICTS_PER_WAREHOUSE + 1);
+}
+uint64_t districtSeed(uint32_t w_id, uint32_t d_id)
+{
+  return warehouseSeed(w_id) + d_id;
+}
+}  // namespace
+
+// rows written per table and the loader thread time they took
+struct Database::LoadCounters {
+  std::atomic<uint64_t> rows[LOADED_COUNT] = {};
+  std::atomic<uint64_t> nanos[LOADED_COUNT] = {};
+
+  void add(Loaded table, uint64_t count, std::chrono::steady_clock::time_point start)
+  {
+    rows[static_cast<size_t>(table)] += count;
+    nanos[static_cast<size_t>(table)] +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+Database::Database(uint32_t warehouseCount)
+    : warehouseCount(warehouseCount),
+      districtOrders(warehouseCount * DISTRICTS_PER_WAREHOUSE),
+      histories(warehouseCount),
+      nameIndexes(warehouseCount * DISTRICTS_PER_WAREHOUSE),
+      latches(new Latch[warehouseCount])
+{
+}
+
+std::vector<TableLoad> Database::populate(unsigned threadCount)
+{
+  uint64_t now = std::time(nullptr);
+  // every table is allocated in its final size up front, the tasks write their rows in place
+  // allocated here rather than in the constructor, a loaded snapshot brings its own rows
+  warehouses = Table<Warehouse>(warehouseCount);
+  districts = Table<District>(warehouseCount * DISTRICTS_PER_WAREHOUSE);
+  customers = Table<Customer>(static_cast<size_t>(warehouseCount) * DISTRICTS_PER_WAREHOUSE * CUSTOMERS_PER_DISTRICT);
+  items = Table<Item>(ITEM_COUNT);
+  stocks = Table<Stock>(static_cast<size_t>(warehouseCount) * ITEM_COUNT);
+  for (Table<History>& h : histories)
+    h = Table<History>(DISTRICTS_PER_WAREHOUSE * CUSTOMERS_PER_DISTRICT);
+
+  // tasks: the warehouses with their stock first, they are the biggest, then the items, then the districts
+  LoadCounters counters;
+  size_t taskCount = warehouseCount + 1 + warehouseCount * DISTRICTS_PER_WAREHOUSE;
+  std::atomic<size_t> nextTask{0};
+  auto work = [&] {
+    for (size_t task; (task = nextTask++) < taskCount;) {
+      if (task < warehouseCount) {
+        loadWarehouse(task + 1, counters);
+      } else if (task == warehouseCount) {
+        loadItems(counters);
+      } else {
+        size_t district = task - warehouseCount - 1;
+        loadDistrict(district / DISTRICTS_PER_WAREHOUSE + 1, district % DISTRICTS_PER_WAREHOUSE + 1, now, counters);
+      }
+    }
+  };
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < std::min<size_t>(threadCount, taskCount); t++)
+    threads.emplace_back(work);
+  work();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  std::vector<TableLoad> loads;
+  for (size_t t = 0; t < LOADED_COUNT; t++)
+    loads.push_back({loadedNames[t], counters.rows[t], counters.nanos[t] / 1e9});
+  return loads;
+}
+
+void Database::loadItems(LoadCounters& counters)
+{
+  leanstore::utils::RandomGenerator::seed(itemSeed());
+  auto start = std::chrono::steady_clock::now();
+  for (Item& item : items) {
+    item.imageId = urand(1, 10000);
+    copy(item.name, randomastring<24>(14, 24));
+    item.price = urand(100, 10000) / 100.0;
+    data(item.data);
+  }
+  counters.add(Loaded::item, ITEM_COUNT, start);
+}
+
+void Database::loadWarehouse(uint32_t w_id, LoadCounters& counters)
+{
+  leanstore::utils::RandomGenerator::seed(warehouseSeed(w_id));
+  auto start = std::chrono::steady_clock::now();
+  Warehouse& w = warehouse(w_id);
+  copy(w.name, randomastring<10>(6, 10));
+  address(w);
+  w.tax = urand(0, 2000) / 10000.0;
+  w.ytd = 300000.00;
+  w.stockVersion = 0;
+  counters.add(Loaded::warehouse, 1, start);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i_id = 1; i_id <= ITEM_COUNT; i_id++) {
+    Stock& s = stock(w_id, i_id);
+    s.quantity = urand(10, 100);
+    for (auto& dist : s.dist)
+      copy(dist, randomastring<24>(24, 24));
+    s.ytd = 0;
+    s.orderCount = 0;
+    s.remoteCount = 0;
+    data(s.data);
+  }
+  counters.add(Loaded::stock, ITEM_COUNT, start);
+}
+
+void Database::loadDistrict(uint32_t w_id, uint32_t d_id, uint64_t now, LoadCounters& counters)
+{
+  leanstore::utils::RandomGenerator::seed(districtSeed(w_id, d_id));
+  auto start = std::chrono::steady_clock::now();
+  District& d = district(w_id, d_id);
+  copy(d.name, randomastring<10>(6, 10));
+  address(d);
+  d.tax = urand(0, 2000) / 10000.0;
+  d.ytd = 30000.00;
+  d.nextOrderId = INITIAL_ORDERS_PER_DISTRICT + 1;
+  d.oldestNewOrder = INITIAL_ORDERS_PER_DISTRICT - INITIAL_NEW_ORDERS_PER_DISTRICT + 1;
+  counters.add(Loaded::district, 1, start);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t c_id = 1; c_id <= CUSTOMERS_PER_DISTRICT; c_id++) {
+    Customer& c = customer(w_id, d_id, c_id);
+    copy(c.first, randomastring<16>(8, 16));
+    memcpy(c.middle, "OE", 2);
+    // every name occurs at least once, the rest follow NURand with C_LAST_LOAD_C (spec 4.3.2.3)
+    copy(c.last, genName(c_id <= 1000 ? c_id - 1 : getNonUniformRandomLastNameForLoad()));
+    address(c);
+    copy(c.phone, randomnstring(16, 16));
+    c.since = now;
+    memcpy(c.credit, urand(1, 10) == 1 ? "BC" : "GC", 2);
+    c.creditLimit = 50000.00;
+    c.discount = urand(0, 5000) / 10000.0;
+    c.balance = -10.00;
+    c.ytdPayment = 10.00;
+    c.paymentCount = 1;
+    c.deliveryCount = 0;
+    copy(c.data, randomastring<500>(300, 500));
+    c.version = 0;
+    // set with the orders below
+    c.lastOrderId = 0;
+  }
+  counters.add(Loaded::customer, CUSTOMERS_PER_DISTRICT, start);
+  nameIndexes[districtIndex(w_id, d_id)].build(&customer(w_id, d_id, 1));
+
+  // the district's rows of its warehouse's history
+  start = std::chrono::steady_clock::now();
+  History* h = &history(w_id)[(d_id - 1) * CUSTOMERS_PER_DISTRICT];
+  for (uint32_t c_id = 1; c_id <= CUSTOMERS_PER_DISTRICT; c_id++, h++) {
+    *h = {c_id, d_id, w_id, d_id, w_id, now, 10.00, {}};
+    copy(h->data, randomastring<24>(12, 24));
+  }
+  counters.add(Loaded::history, CUSTOMERS_PER_DISTRICT, start);
+
+  // one order per customer in random customer order
+  start = std::chrono::steady_clock::now();
+  std::vector<uint32_t> customerIds(CUSTOMERS_PER_DISTRICT);
+  for (uint32_t i = 0; i < CUSTOMERS_PER_DISTRICT; i++)
+    customerIds[i] = i + 1;
+  for (size_t i = CUSTOMERS_PER_DISTRICT - 1; i > 0; i--)
+    std::swap(customerIds[i], customerIds[rnd(i + 1)]);
+
+  DistrictOrders& o = orders(w_id, d_id);
+  o.orders = Table<Order>(INITIAL_ORDERS_PER_DISTRICT);
+  uint32_t lineCount = 0;
+  for (uint32_t o_id = 1; o_id <= INITIAL_ORDERS_PER_DISTRICT; o_id++) {
+    Order& order = o.orders[o_id - 1];
+    order.customerId = customerIds[o_id - 1];
+    customer(w_id, d_id, order.customerId).lastOrderId = o_id;
+    order.carrierId = o_id < d.oldestNewOrder ? urand(1, 10) : 0;
+    order.entryDate = now;
+    order.firstLine = lineCount;
+    order.lineCount = urand(5, 15);
+    order.allLocal = true;
+    lineCount += order.lineCount;
+  }
+  counters.add(Loaded::order, INITIAL_ORDERS_PER_DISTRICT, start);
+
+  start = std::chrono::steady_clock::now();
+  o.lines.reserve(INITIAL_ORDERS_PER_DISTRICT * MAX_ORDER_LINES);
+  o.lines.resize(lineCount);
+  for (uint32_t o_id = 1; o_id <= INITIAL_ORDERS_PER_DISTRICT; o_id++) {
+    const Order& order = o.orders[o_id - 1];
+    bool delivered = o_id < d.oldestNewOrder;
+    for (uint32_t l = order.firstLine; l < order.firstLine + order.lineCount; l++) {
+      OrderLine& line = o.lines[l];
+      line.itemId = urand(1, ITEM_COUNT);
+      line.supplyWarehouseId = w_id;
+      line.deliveryDate = delivered ? now : 0;
+      line.quantity = 5;
+      line.amount = delivered ? 0.00 : urand(1, 999999) / 100.0;
+      copy(line.distInfo, randomastring<24>(24, 24));
+    }
+  }
+  counters.add(Loaded::orderLine, lineCount, start);
+}
+
+template <typename F>
+void Database::forEachTable(F f)
+{
+  f(warehouses);
+  f(districts);
+  f(customers);
+  f(items);
+  f(stocks);
+  for (DistrictOrders& o : districtOrders) {
+    f(o.orders);
+    f(o.lines);
+  }
+  for (Table<History>& h : histories)
+    f(h);
+}
+
+void Database::save(const std::string& path, uint64_t lsn)
+{
+  size_t sectionCount = 0;
+  forEachTable([&](auto&) { sectionCount++; });
+  SnapshotWriter writer(path, warehouseCount, lsn, sectionCount);
+  forEachTable([&](auto& table) { writer.add(table); });
+  writer.finish();
+}
+
+bool Database::load(const std::string& path)
+{
+  if (!snapshot.open(path))
+    return false;
+  if (snapshot.getHeader().warehouseCount != warehouseCount) {
+    std::cerr << "snapshot " << path << " holds " << snapshot.getHeader().warehouseCount << " warehouses, not " << warehouseCount << "\n";
+    exit(EXIT_FAILURE);
+  }
+  forEachTable([&](auto& table) { snapshot.view(table); });
+  for (uint32_t w_id = 1; w_id <= warehouseCount; w_id++) {
+    for (uint32_t d_id = 1; d_id <= DISTRICTS_PER_WAREHOUSE; d_id++)
+      nameIndexes[districtIndex(w_id, d_id)].build(&customer(w_id, d_id, 1));
+  }
+  return true;
+}
+
+void Database::lockAll()
+{
+  for (uint32_t w_id = 1; w_id <= warehouseCount; w_id++)
+    latch(w_id).lock();
+}
+
+void Database::unlockAll()
+{
+  for (uint32_t w_id = warehouseCount; w_id >= 1; w_id--)
+    latch(w_id).unlock();
+}
+}  // namespace TPCC
@@ -0,0 +1,220 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "OptimisticLatch.hpp"
+#include "TPCCNameIndex.hpp"
+#include "TPCCSnapshot.hpp"
+#include "TPCCTable.hpp"
+
+namespace TPCC
+{
+inline constexpr uint32_t DISTRICTS_PER_WAREHOUSE = 10;
+inline constexpr uint32_t CUSTOMERS_PER_DISTRICT = 3000;
+inline constexpr uint32_t ITEM_COUNT = 100000;
+inline constexpr uint32_t INITIAL_ORDERS_PER_DISTRICT = 3000;
+// the last 900 initial orders of every district are undelivered
+inline constexpr uint32_t INITIAL_NEW_ORDERS_PER_DISTRICT = 900;
+inline constexpr uint32_t MAX_ORDER_LINES = 15;
+
+// rows of the TPC-C tables (spec 1.3), ids are 1-based like in the spec
+// strings are fixed size and zero padded, money is kept as double like in the client's Numeric
+
+struct Warehouse {
+  char name[10];
+  char street1[20];
+  char street2[20];
+  char city[20];
+  char state[2];
+  char zip[9];
+  double tax;
+  double ytd;
+  // bumped by every NewOrder that updates stock rows of the warehouse, StockLevel results are cached against it
+  uint64_t stockVersion;
+};
+
+struct District {
+  char name[10];
+  char street1[20];
+  char street2[20];
+  char city[20];
+  char state[2];
+  char zip[9];
+  double tax;
+  double ytd;
+  uint32_t nextOrderId;
+  // orders [oldestNewOrder, nextOrderId) are undelivered, they form the NEW-ORDER table of the district
+  uint32_t oldestNewOrder;
+};
+
+struct Customer {
+  char first[16];
+  char middle[2];
+  char last[LAST_NAME_LENGTH];
+  char street1[20];
+  char street2[20];
+  char city[20];
+  char state[2];
+  char zip[9];
+  char phone[16];
+  uint64_t since;
+  char credit[2];
+  double creditLimit;
+  double discount;
+  double balance;
+  double ytdPayment;
+  uint32_t paymentCount;
+  uint32_t deliveryCount;
+  char data[500];
+  // bumped by every transaction that writes the customer or its orders, OrderStatus results are cached against it
+  uint64_t version;
+  // o_id of the customer's most recent order in its district, OrderStatus reads it instead of scanning the orders
+  // next to version, so OrderStatus touches a single cache line of the row
+  uint32_t lastOrderId;
+};
+
+struct Item {
+  uint32_t imageId;
+  double price;
+  char name[24];
+  char data[50];
+};
+
+struct Stock {
+  int32_t quantity;
+  uint32_t ytd;
+  uint32_t orderCount;
+  uint32_t remoteCount;
+  char dist[DISTRICTS_PER_WAREHOUSE][24];
+  char data[50];
+};
+
+struct Order {
+  uint32_t customerId;
+  uint32_t carrierId;  // 0 = not delivered yet
+  uint64_t entryDate;
+  // lines are [firstLine, firstLine + lineCount) in the district's line vector
+  uint32_t firstLine;
+  uint8_t lineCount;
+  bool allLocal;
+};
+
+struct OrderLine {
+  uint32_t itemId;
+  uint32_t supplyWarehouseId;
+  uint64_t deliveryDate;  // 0 = not delivered yet
+  uint32_t quantity;
+  double amount;
+  char distInfo[24];
+};
+
+struct History {
+  uint32_t customerId;
+  uint32_t customerDistrictId;
+  uint32_t customerWarehouseId;
+  uint32_t districtId;
+  uint32_t warehouseId;
+  uint64_t date;
+  double amount;
+  char data[24];
+};
+
+// orders of a district in o_id order, order o_id is orders[o_id - 1]
+// the orders form an append-ordered log keyed by o_id, a range of o_ids is a contiguous run of orders and their lines
+// are a contiguous run of lines, so StockLevel's reverse range scan reads a few cache lines whatever the log's length
+struct DistrictOrders {
+  Table<Order> orders;
+  Table<OrderLine> lines;
+};
+
+// rows populate wrote into a table and the loader thread time they took
+struct TableLoad {
+  const char* name;
+  uint64_t rows;
+  double seconds;
+};
+
+// in-memory TPC-C database shared by all reactor threads
+// tables are dense arrays indexed by their ids, every warehouse and everything that belongs to it is protected by
+// the latch of the warehouse. Modifying transactions lock all warehouses they touch in ascending order, read-only
+// ones read optimistically against the version of their warehouse's latch and never write it.
+class Database
+{
+ public:
+  explicit Database(uint32_t warehouseCount);
+
+  // fill the tables with the initial population of spec 4.3.3 on threadCount threads, 0 = one per core
+  // the items, every warehouse with its stock and every district with its customers, history and orders are tasks of
+  // their own with their own seed, so the population does not depend on the thread count
+  std::vector<TableLoad> populate(unsigned threadCount);
+
+  // write all tables to a snapshot at path, lsn is the last redo log record they contain
+  // the caller holds every warehouse latch, so the snapshot is transaction consistent
+  void save(const std::string& path, uint64_t lsn);
+  // map the snapshot at path instead of populating, false if there is none
+  // rows are faulted in when first touched and copied when first written, only the name indexes are built eagerly
+  bool load(const std::string& path);
+  // lsn of the loaded snapshot, 0 if the tables were populated
+  uint64_t getSnapshotLsn() const { return snapshot.getSize() ? snapshot.getHeader().lsn : 0; }
+  size_t getSnapshotSize() const { return snapshot.getSize(); }
+
+  // ascending, like transactions lock
+  void lockAll();
+  void unlockAll();
+
+  uint32_t getWarehouseCount() const { return warehouseCount; }
+
+  bool validWarehouse(uint32_t w_id) const { return w_id >= 1 && w_id <= warehouseCount; }
+  static bool validDistrict(uint32_t d_id) { return d_id >= 1 && d_id <= DISTRICTS_PER_WAREHOUSE; }
+  static bool validCustomer(uint32_t c_id) { return c_id >= 1 && c_id <= CUSTOMERS_PER_DISTRICT; }
+
+  Warehouse& warehouse(uint32_t w_id) { return warehouses[w_id - 1]; }
+  District& district(uint32_t w_id, uint32_t d_id) { return districts[districtIndex(w_id, d_id)]; }
+  Customer& customer(uint32_t w_id, uint32_t d_id, uint32_t c_id)
+  {
+    return customers[districtIndex(w_id, d_id) * CUSTOMERS_PER_DISTRICT + c_id - 1];
+  }
+  // nullptr for unused item ids, the 1% of NewOrders with an invalid item roll back on this
+  const Item* item(uint32_t i_id) const { return i_id >= 1 && i_id <= ITEM_COUNT ? &items[i_id - 1] : nullptr; }
+  Stock& stock(uint32_t w_id, uint32_t i_id) { return stocks[static_cast<size_t>(w_id - 1) * ITEM_COUNT + i_id - 1]; }
+  DistrictOrders& orders(uint32_t w_id, uint32_t d_id) { return districtOrders[districtIndex(w_id, d_id)]; }
+  Table<History>& history(uint32_t w_id) { return histories[w_id - 1]; }
+  const CustomerNameIndex& customersByName(uint32_t w_id, uint32_t d_id) const { return nameIndexes[districtIndex(w_id, d_id)]; }
+
+  OptimisticLatch& latch(uint32_t w_id) { return latches[w_id - 1].latch; }
+
+ private:
+  struct alignas(64) Latch {
+    OptimisticLatch latch;
+  };
+
+  uint32_t warehouseCount;
+  // declared before the tables, which may be views into it
+  SnapshotMapping snapshot;
+  Table<Warehouse> warehouses;
+  Table<District> districts;
+  Table<Customer> customers;
+  Table<Item> items;
+  Table<Stock> stocks;
+  std::vector<DistrictOrders> districtOrders;
+  std::vector<Table<History>> histories;
+  std::vector<CustomerNameIndex> nameIndexes;
+  std::unique_ptr<Latch[]> latches;
+
+  struct LoadCounters;
+
+  // tasks of populate
+  void loadItems(LoadCounters& counters);
+  void loadWarehouse(uint32_t w_id, LoadCounters& counters);
+  void loadDistrict(uint32_t w_id, uint32_t d_id, uint64_t now, LoadCounters& counters);
+
+  // call f with every table in snapshot order
+  template <typename F>
+  void forEachTable(F f);
+
+  static size_t districtIndex(uint32_t w_id, uint32_t d_id) { return static_cast<size_t>(w_id - 1) * DISTRICTS_PER_WAREHOUSE + d_id - 1; }
+};
+}  // namespace TPCC
@@ -0,0 +1,133 @@
+#include "TPCCDeliveryQueue.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "AdmissionControl.hpp"
+#include "TPCCLog.hpp"
+
+namespace TPCC
+{
+namespace
+{
+// Deliveries of one warehouse executed under one latching, bounds how long the worker holds a warehouse's latch
+// while it catches up on a long queue
+constexpr size_t DELIVERY_GROUP_SIZE = 32;
+}  // namespace
+
+DeliveryQueue::DeliveryQueue(Database& database, LogWriter* log, size_t capacity)
+    : database(database), executor(database, log), capacity(capacity)
+{
+}
+
+DeliveryQueue::~DeliveryQueue()
+{
+  if (!thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    stopping = true;
+  }
+  wakeup.notify_one();
+  thread.join();
+}
+
+void DeliveryQueue::start()
+{
+  thread = std::thread(&DeliveryQueue::run, this);
+}
+
+void DeliveryQueue::push(Transaction* const* group, size_t count, LogWriter* log)
+{
+  uint64_t now = nowNanos();
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    accepted.clear();
+    for (size_t i = 0; i < count; i++) {
+      Transaction& transaction = *group[i];
+      const FunctionParams::Delivery& p = transaction.params.delivery;
+      transaction.result = 0;
+      // checked here, the client is answered before the worker executes it
+      if (!database.validWarehouse(p.w_id) || p.carrier_id < 1 || p.carrier_id > 10) {
+        transaction.code = ResponseCode::invalid;
+        continue;
+      }
+      if (queue.size() + accepted.size() + running >= capacity) {
+        transaction.code = ResponseCode::busy;
+        rejectedCounter++;
+        continue;
+      }
+      accepted.push_back(&transaction);
+    }
+    // logged under the latch, so the worker cannot execute a Delivery before its queued record has an LSN
+    if (log && !accepted.empty())
+      log->appendQueued(accepted.data(), accepted.size());
+    for (Transaction* transaction : accepted)
+      queue.push_back({transaction->params, transaction->queuedLsn, now});
+    queued = !accepted.empty();
+    maxDepth = std::max(maxDepth, queue.size() + running);
+  }
+  if (queued)
+    wakeup.notify_one();
+}
+
+void DeliveryQueue::moveMetrics(Metrics& metrics)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  metrics.executed = std::exchange(executed, 0);
+  metrics.depth = queue.size() + running;
+  metrics.maxDepth = std::exchange(maxDepth, metrics.depth);
+  metrics.lag.merge(lag);
+  lag.reset();
+}
+
+void DeliveryQueue::run()
+{
+  std::vector<Request> requests;
+  std::vector<Transaction> transactions;
+  std::vector<Transaction*> order;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(latch);
+      wakeup.wait(lock, [&] { return !queue.empty() || stopping; });
+      if (queue.empty())
+        return;
+      requests.swap(queue);
+      running = requests.size();
+    }
+
+    transactions.resize(requests.size());
+    order.clear();
+    for (size_t i = 0; i < requests.size(); i++) {
+      Transaction& transaction = transactions[i];
+      transaction.funcID = FunctionID::delivery;
+      transaction.code = ResponseCode::ok;
+      transaction.params = requests[i].params;
+      transaction.queuedLsn = requests[i].queuedLsn;
+      order.push_back(&transaction);
+    }
+    // a warehouse's Deliveries in the order they were queued
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Transaction* a, const Transaction* b) { return a->params.delivery.w_id < b->params.delivery.w_id; });
+
+    for (size_t begin = 0; begin != order.size();) {
+      uint32_t w_id = order[begin]->params.delivery.w_id;
+      size_t end = begin + 1;
+      while (end != order.size() && end - begin < DELIVERY_GROUP_SIZE && order[end]->params.delivery.w_id == w_id)
+        end++;
+      executor.run(FunctionID::delivery, &order[begin], end - begin, nullptr);
+
+      uint64_t now = nowNanos();
+      std::lock_guard<std::mutex> guard(latch);
+      for (size_t i = begin; i < end; i++)
+        lag.record(now - requests[order[i] - transactions.data()].queued);
+      executed += end - begin;
+      running -= end - begin;
+      begin = end;
+    }
+    requests.clear();
+  }
+}
+}  // namespace TPCC
@@ -0,0 +1,76 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Stats/Histogram.hpp"
+#include "TPCCExecutor.hpp"
+
+namespace TPCC
+{
+// Delivery transactions run deferred (spec 2.7.2): the reactor thread answers a Delivery as soon as it is queued, a
+// worker thread executes it later. The worker takes everything queued since its last round and runs it grouped by
+// warehouse, so the ten districts of every Delivery are updated without holding up the connections of a reactor
+// thread and a warehouse is latched once per group.
+// With a redo log a Delivery is logged when it is queued, so its response waits for that record like the ones of
+// other modifying transactions, and again when the worker executes it. The server exits without stopping the worker,
+// Deliveries still queued then are executed by the recovery of the next start (see RedoLog); without a log they are
+// lost.
+// The queue is bounded: while capacity Deliveries are waiting, new ones are rejected as busy instead of piling up
+// behind a worker that cannot keep up.
+class DeliveryQueue
+{
+ public:
+  // log = nullptr executes without logging, the worker's own log writer
+  DeliveryQueue(Database& database, LogWriter* log, size_t capacity);
+  ~DeliveryQueue();
+  DeliveryQueue(const DeliveryQueue&) = delete;
+  DeliveryQueue& operator=(const DeliveryQueue&) = delete;
+
+  void start();
+
+  // queue the valid Deliveries of a group with result 0, the others get ResponseCode::invalid, or busy if the queue
+  // is full
+  // log is the log writer of the calling reactor thread, the queued Deliveries are recorded there, nullptr = no log
+  void push(Transaction* const* group, size_t count, LogWriter* log);
+
+  // per interval metrics, reset by moveMetrics
+  struct Metrics {
+    uint64_t executed = 0;
+    // queued and not yet executed, now and at most since the last call
+    size_t depth = 0;
+    size_t maxDepth = 0;
+    // queued -> executed in ns
+    Stats::Histogram lag;
+  };
+  void moveMetrics(Metrics& metrics);
+
+ private:
+  struct Request {
+    FunctionParams params;
+    uint64_t queuedLsn;
+    uint64_t queued;
+  };
+
+  Database& database;
+  Executor executor;
+  size_t capacity;
+  std::mutex latch;
+  std::condition_variable wakeup;
+  std::vector<Request> queue;
+  // Deliveries of the current push, used under latch
+  std::vector<Transaction*> accepted;
+  bool stopping = false;
+  // taken by the worker, not yet executed
+  size_t running = 0;
+  size_t maxDepth = 0;
+  uint64_t executed = 0;
+  Stats::Histogram lag;
+  std::thread thread;
+
+  void run();
+};
+}  // namespace TPCC
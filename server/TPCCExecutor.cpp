@@ -0,0 +1,504 @@
+#include "TPCCExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "TPCCLog.hpp"
+
+namespace TPCC
+{
+namespace
+{
+double toDouble(uint64_t bits)
+{
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// optimistic attempts of a read-only transaction before it locks, a writer that keeps interfering must not starve it
+constexpr int OPTIMISTIC_ATTEMPTS = 8;
+
+}  // namespace
+
+std::atomic<uint64_t> optimisticRestarts = 0;
+std::atomic<uint64_t> optimisticLocks = 0;
+
+Executor::Executor(Database& database, LogWriter* log, const ResultCache::Config& cache)
+    : database(database),
+      log(log),
+      caches{ResultCache(cache.enabled[static_cast<size_t>(CachedFunction::stockLevel)] ? cache.size : 0),
+             ResultCache(cache.enabled[static_cast<size_t>(CachedFunction::orderStatus)] ? cache.size : 0)}
+{
+}
+
+uint32_t Executor::homeWarehouse(const Transaction& transaction)
+{
+  const FunctionParams& p = transaction.params;
+  switch (transaction.funcID) {
+    case FunctionID::newOrder:
+      return p.newOrder.w_id;
+    case FunctionID::delivery:
+      return p.delivery.w_id;
+    case FunctionID::stockLevel:
+      return p.stockLevel.w_id;
+    case FunctionID::orderStatusId:
+      return p.orderStatusId.w_id;
+    case FunctionID::orderStatusName:
+      return p.orderStatusName.w_id;
+    case FunctionID::paymentById:
+      return p.paymentById.w_id;
+    case FunctionID::paymentByName:
+      return p.paymentByName.w_id;
+    case FunctionID::notSet:
+    case FunctionID::batch:
+      break;
+  }
+  return 0;
+}
+
+bool Executor::readOnly(FunctionID funcID)
+{
+  return funcID == FunctionID::stockLevel || funcID == FunctionID::orderStatusId || funcID == FunctionID::orderStatusName;
+}
+
+void Executor::run(FunctionID funcID, Transaction* const* group, size_t count, const OrderLineRequest* lines)
+{
+  if (readOnly(funcID)) {
+    for (size_t i = 0; i < count; i++) {
+      Transaction& transaction = *group[i];
+      if (!validate(transaction, lines)) {
+        transaction.code = ResponseCode::invalid;
+        continue;
+      }
+      if (funcID == FunctionID::stockLevel) {
+        readOptimistically(transaction.params.stockLevel.w_id, [&](auto valid) { return stockLevel(transaction, valid); });
+        continue;
+      }
+      // the name index never changes, it is read outside of the latch
+      uint32_t c_id = funcID == FunctionID::orderStatusId
+                          ? transaction.params.orderStatusId.c_id
+                          : findCustomer(transaction.params.orderStatusName.w_id, transaction.params.orderStatusName.d_id,
+                                         transaction.params.orderStatusName.c_last);
+      if (c_id == 0) {
+        transaction.code = ResponseCode::invalid;
+        continue;
+      }
+      readOptimistically(homeWarehouse(transaction), [&](auto valid) { return orderStatus(transaction, c_id, valid); });
+    }
+    for (size_t f = 0; f < CACHED_FUNCTION_COUNT; f++)
+      caches[f].publish(cacheCounters[f]);
+    return;
+  }
+
+  // ids are checked before anything is locked, the lock set is the home warehouse plus the remote ones of the group
+  lockSet.clear();
+  for (size_t i = 0; i < count; i++) {
+    Transaction& transaction = *group[i];
+    if (!validate(transaction, lines)) {
+      transaction.code = ResponseCode::invalid;
+      continue;
+    }
+    lockSet.push_back(homeWarehouse(transaction));
+    if (funcID == FunctionID::newOrder) {
+      const OrderLineRequest* line = lines + transaction.firstLine;
+      for (size_t l = 0; l < transaction.params.newOrder.vecSize; l++)
+        lockSet.push_back(line[l].supplyWarehouseId);
+    } else if (funcID == FunctionID::paymentById) {
+      lockSet.push_back(transaction.params.paymentById.c_w_id);
+    } else if (funcID == FunctionID::paymentByName) {
+      lockSet.push_back(transaction.params.paymentByName.c_w_id);
+    }
+  }
+  if (lockSet.empty())
+    return;
+  std::sort(lockSet.begin(), lockSet.end());
+  lockSet.erase(std::unique(lockSet.begin(), lockSet.end()), lockSet.end());
+
+  lock();
+  if (funcID == FunctionID::newOrder) {
+    newOrders(group, count, lines);
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      Transaction& transaction = *group[i];
+      if (transaction.code != ResponseCode::ok)
+        continue;
+      switch (funcID) {
+        case FunctionID::delivery:
+          delivery(transaction);
+          break;
+        case FunctionID::paymentById:
+        case FunctionID::paymentByName:
+          payment(transaction);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // LSNs are taken before the latches are released, so conflicting transactions are logged in execution order
+  if (log) {
+    committed.clear();
+    for (size_t i = 0; i < count; i++) {
+      if (group[i]->code == ResponseCode::ok)
+        committed.push_back(group[i]);
+    }
+    if (!committed.empty())
+      log->append(committed.data(), committed.size(), lines);
+  }
+  unlock();
+
+  for (size_t f = 0; f < CACHED_FUNCTION_COUNT; f++)
+    caches[f].publish(cacheCounters[f]);
+}
+
+bool Executor::validate(Transaction& transaction, const OrderLineRequest* lines)
+{
+  const FunctionParams& p = transaction.params;
+  if (!database.validWarehouse(homeWarehouse(transaction)))
+    return false;
+  switch (transaction.funcID) {
+    case FunctionID::newOrder: {
+      if (!Database::validDistrict(p.newOrder.d_id) || !Database::validCustomer(p.newOrder.c_id) || p.newOrder.vecSize == 0 ||
+          p.newOrder.vecSize > MAX_ORDER_LINES)
+        return false;
+      const OrderLineRequest* line = lines + transaction.firstLine;
+      for (size_t l = 0; l < p.newOrder.vecSize; l++) {
+        if (!database.validWarehouse(line[l].supplyWarehouseId) || line[l].quantity == 0)
+          return false;
+      }
+      return true;
+    }
+    case FunctionID::delivery:
+      return p.delivery.carrier_id >= 1 && p.delivery.carrier_id <= 10;
+    case FunctionID::stockLevel:
+      return Database::validDistrict(p.stockLevel.d_id);
+    case FunctionID::orderStatusId:
+      return Database::validDistrict(p.orderStatusId.d_id) && Database::validCustomer(p.orderStatusId.c_id);
+    case FunctionID::orderStatusName:
+      return Database::validDistrict(p.orderStatusName.d_id);
+    case FunctionID::paymentById:
+      return Database::validDistrict(p.paymentById.d_id) && database.validWarehouse(p.paymentById.c_w_id) &&
+             Database::validDistrict(p.paymentById.c_d_id) && Database::validCustomer(p.paymentById.c_id);
+    case FunctionID::paymentByName:
+      return Database::validDistrict(p.paymentByName.d_id) && database.validWarehouse(p.paymentByName.c_w_id) &&
+             Database::validDistrict(p.paymentByName.c_d_id);
+    case FunctionID::notSet:
+    case FunctionID::batch:
+      break;
+  }
+  return false;
+}
+
+template <typename Read>
+void Executor::readOptimistically(uint32_t w_id, Read read)
+{
+  OptimisticLatch& latch = database.latch(w_id);
+  for (int attempt = 0; attempt < OPTIMISTIC_ATTEMPTS; attempt++) {
+    uint64_t version = latch.readLock();
+    if (read([&] { return latch.validate(version); }))
+      return;
+    optimisticRestarts++;
+  }
+  optimisticLocks++;
+  latch.lock();
+  read([] { return true; });
+  latch.unlock();
+}
+
+void Executor::lock()
+{
+  for (uint32_t w_id : lockSet)
+    database.latch(w_id).lock();
+}
+
+void Executor::unlock()
+{
+  for (auto it = lockSet.rbegin(); it != lockSet.rend(); ++it)
+    database.latch(*it).unlock();
+}
+
+// spec 2.4.2, amortized over the group: the warehouse row is read once, every district's order ids are reserved with a
+// single update of d_next_o_id, and the item and stock rows of all lines are prefetched before the first order runs
+void Executor::newOrders(Transaction* const* group, size_t count, const OrderLineRequest* lines)
+{
+  uint32_t w_id = group[0]->params.newOrder.w_id;
+  const Warehouse& warehouse = database.warehouse(w_id);
+
+  uint32_t ordersPerDistrict[DISTRICTS_PER_WAREHOUSE] = {};
+  for (size_t i = 0; i < count; i++) {
+    Transaction& transaction = *group[i];
+    if (transaction.code != ResponseCode::ok)
+      continue;
+    // an unused item id rolls the whole order back, so it is found before anything is written
+    const OrderLineRequest* line = lines + transaction.firstLine;
+    for (size_t l = 0; l < transaction.params.newOrder.vecSize; l++) {
+      const Item* item = database.item(line[l].itemId);
+      if (!item) {
+        transaction.code = ResponseCode::aborted;
+        break;
+      }
+      __builtin_prefetch(item);
+      __builtin_prefetch(&database.stock(line[l].supplyWarehouseId, line[l].itemId), 1);
+    }
+    if (transaction.code == ResponseCode::ok)
+      ordersPerDistrict[transaction.params.newOrder.d_id - 1]++;
+  }
+
+  uint32_t nextOrderId[DISTRICTS_PER_WAREHOUSE];
+  for (uint32_t d = 0; d < DISTRICTS_PER_WAREHOUSE; d++) {
+    if (ordersPerDistrict[d] == 0)
+      continue;
+    District& district = database.district(w_id, d + 1);
+    nextOrderId[d] = district.nextOrderId;
+    district.nextOrderId += ordersPerDistrict[d];
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    Transaction& transaction = *group[i];
+    if (transaction.code != ResponseCode::ok)
+      continue;
+    const FunctionParams::NewOrder& p = transaction.params.newOrder;
+    const District& district = database.district(w_id, p.d_id);
+    Customer& customer = database.customer(w_id, p.d_id, p.c_id);
+    DistrictOrders& districtOrders = database.orders(w_id, p.d_id);
+    customer.version++;
+
+    Order order;
+    order.customerId = p.c_id;
+    order.carrierId = 0;
+    order.entryDate = p.timestamp;
+    order.firstLine = districtOrders.lines.size();
+    order.lineCount = p.vecSize;
+    order.allLocal = true;
+
+    double total = 0;
+    const OrderLineRequest* line = lines + transaction.firstLine;
+    for (size_t l = 0; l < p.vecSize; l++) {
+      const Item& item = *database.item(line[l].itemId);
+      Stock& stock = database.stock(line[l].supplyWarehouseId, line[l].itemId);
+      int32_t quantity = line[l].quantity;
+      if (stock.quantity >= quantity + 10)
+        stock.quantity -= quantity;
+      else
+        stock.quantity = stock.quantity - quantity + 91;
+      stock.ytd += quantity;
+      stock.orderCount++;
+      database.warehouse(line[l].supplyWarehouseId).stockVersion++;
+      if (line[l].supplyWarehouseId != w_id) {
+        stock.remoteCount++;
+        order.allLocal = false;
+      }
+
+      OrderLine orderLine;
+      orderLine.itemId = line[l].itemId;
+      orderLine.supplyWarehouseId = line[l].supplyWarehouseId;
+      orderLine.deliveryDate = 0;
+      orderLine.quantity = quantity;
+      orderLine.amount = quantity * item.price;
+      memcpy(orderLine.distInfo, stock.dist[p.d_id - 1], sizeof(orderLine.distInfo));
+      districtOrders.lines.push_back(orderLine);
+      total += orderLine.amount;
+    }
+    // the total is what the terminal displays, nothing is stored
+    total *= (1 - customer.discount) * (1 + warehouse.tax + district.tax);
+    (void)total;
+
+    districtOrders.orders.push_back(order);
+    customer.lastOrderId = nextOrderId[p.d_id - 1];
+    transaction.result = nextOrderId[p.d_id - 1]++;
+  }
+}
+
+// spec 2.5.2
+void Executor::payment(Transaction& transaction)
+{
+  uint32_t w_id, d_id, c_w_id, c_d_id, c_id;
+  uint64_t date, amountBits;
+  if (transaction.funcID == FunctionID::paymentById) {
+    const FunctionParams::PaymentById& p = transaction.params.paymentById;
+    w_id = p.w_id, d_id = p.d_id, c_w_id = p.c_w_id, c_d_id = p.c_d_id, c_id = p.c_id;
+    date = p.h_date, amountBits = p.h_amount;
+  } else {
+    const FunctionParams::PaymentByName& p = transaction.params.paymentByName;
+    w_id = p.w_id, d_id = p.d_id, c_w_id = p.c_w_id, c_d_id = p.c_d_id;
+    date = p.h_date, amountBits = p.h_amount;
+    c_id = findCustomer(c_w_id, c_d_id, p.c_last);
+    if (c_id == 0) {
+      transaction.code = ResponseCode::invalid;
+      return;
+    }
+  }
+  double amount = toDouble(amountBits);
+
+  Warehouse& warehouse = database.warehouse(w_id);
+  District& district = database.district(w_id, d_id);
+  Customer& customer = database.customer(c_w_id, c_d_id, c_id);
+  warehouse.ytd += amount;
+  district.ytd += amount;
+  customer.balance -= amount;
+  customer.ytdPayment += amount;
+  customer.paymentCount++;
+  customer.version++;
+  if (memcmp(customer.credit, "BC", 2) == 0) {
+    // bad credit: prepend the payment to c_data, truncated to 500 characters
+    char entry[64];
+    int n = snprintf(entry, sizeof(entry), "%u %u %u %u %u %.2f|", c_id, c_d_id, c_w_id, d_id, w_id, amount);
+    n = std::min<int>(n, sizeof(entry) - 1);
+    memmove(customer.data + n, customer.data, sizeof(customer.data) - n);
+    memcpy(customer.data, entry, n);
+  }
+
+  History history{c_id, c_d_id, c_w_id, d_id, w_id, date, amount, {}};
+  // h_data is w_name and d_name separated by four spaces
+  size_t w = strnlen(warehouse.name, sizeof(warehouse.name));
+  size_t d = std::min(strnlen(district.name, sizeof(district.name)), sizeof(history.data) - w - 4);
+  memcpy(history.data, warehouse.name, w);
+  memcpy(history.data + w, "    ", 4);
+  memcpy(history.data + w + 4, district.name, d);
+  database.history(w_id).push_back(history);
+
+  transaction.result = c_id;
+}
+
+// spec 2.6.2, the customer's most recent order is the one its row points to
+template <typename Valid>
+bool Executor::orderStatus(Transaction& transaction, uint32_t c_id, Valid valid)
+{
+  uint32_t w_id, d_id;
+  if (transaction.funcID == FunctionID::orderStatusId)
+    w_id = transaction.params.orderStatusId.w_id, d_id = transaction.params.orderStatusId.d_id;
+  else
+    w_id = transaction.params.orderStatusName.w_id, d_id = transaction.params.orderStatusName.d_id;
+
+  // a hit is only taken for a version that was current
+  ResultCache& cache = caches[static_cast<size_t>(CachedFunction::orderStatus)];
+  const Customer& customer = database.customer(w_id, d_id, c_id);
+  uint64_t version = customer.version;
+  uint32_t result = customer.lastOrderId;
+  if (!valid())
+    return false;
+  if (cache.find(w_id, d_id, c_id, version, transaction.result))
+    return true;
+  auto start = std::chrono::steady_clock::now();
+
+  // spec 2.6.2: the customer's last order and the range of its lines, a torn read starts over
+  if (result != 0) {
+    const DistrictOrders& districtOrders = database.orders(w_id, d_id);
+    size_t orderCount, lineCount;
+    const Order* orders = districtOrders.orders.readRows(orderCount);
+    districtOrders.lines.readRows(lineCount);
+    if (result > orderCount)
+      return false;
+    const Order& order = orders[result - 1];
+    if (order.customerId != c_id || order.firstLine + order.lineCount > lineCount)
+      return false;
+    if (!valid())
+      return false;
+  }
+  transaction.result = result;
+
+  if (cache.enabled()) {
+    cache.insert(w_id, d_id, c_id, version, transaction.result);
+    cache.recordMiss(nanosSince(start));
+  }
+  return true;
+}
+
+// spec 2.7.4, delivers the oldest undelivered order of every district of the warehouse
+void Executor::delivery(Transaction& transaction)
+{
+  const FunctionParams::Delivery& p = transaction.params.delivery;
+  uint32_t delivered = 0;
+  for (uint32_t d_id = 1; d_id <= DISTRICTS_PER_WAREHOUSE; d_id++) {
+    District& district = database.district(p.w_id, d_id);
+    if (district.oldestNewOrder == district.nextOrderId)
+      continue;
+    DistrictOrders& districtOrders = database.orders(p.w_id, d_id);
+    Order& order = districtOrders.orders[district.oldestNewOrder - 1];
+    district.oldestNewOrder++;
+
+    order.carrierId = p.carrier_id;
+    double amount = 0;
+    for (size_t l = order.firstLine; l < order.firstLine + order.lineCount; l++) {
+      OrderLine& line = districtOrders.lines[l];
+      line.deliveryDate = p.datetime;
+      amount += line.amount;
+    }
+    Customer& customer = database.customer(p.w_id, d_id, order.customerId);
+    customer.balance += amount;
+    customer.deliveryCount++;
+    customer.version++;
+    delivered++;
+  }
+  transaction.result = delivered;
+}
+
+// spec 2.8.2, distinct items of the district's last 20 orders whose stock is below the threshold
+// rows read without the latch may be torn, ids taken from them are range checked before they are followed
+template <typename Valid>
+bool Executor::stockLevel(Transaction& transaction, Valid valid)
+{
+  const FunctionParams::StockLevel& p = transaction.params.stockLevel;
+  const District& district = database.district(p.w_id, p.d_id);
+  const DistrictOrders& districtOrders = database.orders(p.w_id, p.d_id);
+
+  // both counters only grow, so their sum changes whenever the last 20 orders or a stock row of the warehouse did
+  ResultCache& cache = caches[static_cast<size_t>(CachedFunction::stockLevel)];
+  uint32_t nextOrderId = district.nextOrderId;
+  uint64_t version = nextOrderId + database.warehouse(p.w_id).stockVersion;
+  if (!valid())
+    return false;
+  if (cache.find(p.w_id, p.d_id, p.threshold, version, transaction.result))
+    return true;
+  auto start = std::chrono::steady_clock::now();
+
+  size_t orderCount, lineCount;
+  const Order* orders = districtOrders.orders.readRows(orderCount);
+  const OrderLine* lines = districtOrders.lines.readRows(lineCount);
+  itemIds.clear();
+  uint32_t first = nextOrderId > 20 ? nextOrderId - 20 : 1;
+  for (uint32_t o_id = first; o_id < nextOrderId; o_id++) {
+    if (o_id > orderCount)
+      return false;
+    const Order& order = orders[o_id - 1];
+    if (order.firstLine + order.lineCount > lineCount)
+      return false;
+    for (size_t l = order.firstLine; l < order.firstLine + order.lineCount; l++)
+      itemIds.push_back(lines[l].itemId);
+  }
+  std::sort(itemIds.begin(), itemIds.end());
+  itemIds.erase(std::unique(itemIds.begin(), itemIds.end()), itemIds.end());
+
+  uint32_t lowStock = 0;
+  for (uint32_t i_id : itemIds) {
+    if (!database.item(i_id))
+      return false;
+    if (database.stock(p.w_id, i_id).quantity < static_cast<int32_t>(p.threshold))
+      lowStock++;
+  }
+  if (!valid())
+    return false;
+  transaction.result = lowStock;
+
+  if (cache.enabled()) {
+    cache.insert(p.w_id, p.d_id, p.threshold, version, transaction.result);
+    cache.recordMiss(nanosSince(start));
+  }
+  return true;
+}
+
+uint32_t Executor::findCustomer(uint32_t w_id, uint32_t d_id, const char* last)
+{
+  NameMatches matches = database.customersByName(w_id, d_id).find(last);
+  return matches.count == 0 ? 0 : matches.ids[(matches.count - 1) / 2];
+}
+}  // namespace TPCC
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "TPCCDatabase.hpp"
+#include "TPCCParser.hpp"
+#include "TPCCPhaseStats.hpp"
+#include "TPCCResultCache.hpp"
+
+namespace TPCC
+{
+class LogWriter;
+
+struct OrderLineRequest {
+  uint32_t supplyWarehouseId;
+  uint32_t itemId;
+  uint32_t quantity;
+};
+
+// a parsed transaction waiting in a batch, and its outcome after execution
+struct Transaction {
+  FunctionID funcID;
+  ResponseCode code;
+  // payload of an ok response, see Response.hpp
+  uint32_t result;
+  FunctionParams params;
+  // NewOrder lines in the line vector of the batch
+  uint32_t firstLine;
+  std::vector<uint8_t>* outBuffer;
+  // connection the request came from, reported back when the response was appended to outBuffer
+  void* owner;
+  Timing timing;
+  Framing framing;
+  // LSN of the record that queued a deferred Delivery, 0 = not deferred
+  uint64_t queuedLsn;
+};
+
+// optimistic reads that started over because a writer locked their warehouse meanwhile, and the ones that gave up and
+// locked it, summed over all threads
+extern std::atomic<uint64_t> optimisticRestarts;
+extern std::atomic<uint64_t> optimisticLocks;
+
+// runs the TPC-C transactions of spec 2.4 - 2.8 on the database, one instance per reactor thread
+class Executor
+{
+ public:
+  // log = nullptr executes without logging, e.g. while the log is replayed
+  explicit Executor(Database& database, LogWriter* log = nullptr, const ResultCache::Config& cache = {});
+
+  // warehouse a transaction is grouped by, the one of the terminal that issued it
+  static uint32_t homeWarehouse(const Transaction& transaction);
+  static bool readOnly(FunctionID funcID);
+
+  // execute count transactions of funcID with the same home warehouse
+  // all warehouses a modifying group touches are locked once for the whole group, read-only transactions run
+  // optimistically one by one
+  void run(FunctionID funcID, Transaction* const* group, size_t count, const OrderLineRequest* lines);
+
+ private:
+  Database& database;
+  LogWriter* log;
+  // warehouses locked by the current group, ascending
+  std::vector<uint32_t> lockSet;
+  std::vector<uint32_t> itemIds;
+  std::vector<Transaction*> committed;
+  // results of the read-only transactions, indexed by CachedFunction
+  ResultCache caches[CACHED_FUNCTION_COUNT];
+
+  bool validate(Transaction& transaction, const OrderLineRequest* lines);
+  void lock();
+  void unlock();
+
+  void newOrders(Transaction* const* group, size_t count, const OrderLineRequest* lines);
+  void payment(Transaction& transaction);
+  void delivery(Transaction& transaction);
+  // read-only, valid() tells whether the rows read so far are consistent, they return false as soon as it does not
+  template <typename Valid>
+  bool orderStatus(Transaction& transaction, uint32_t c_id, Valid valid);
+  template <typename Valid>
+  bool stockLevel(Transaction& transaction, Valid valid);
+
+  // run a read-only transaction on warehouse w_id without locking, repeated while writers interfere and under the
+  // latch after too many attempts
+  template <typename Read>
+  void readOptimistically(uint32_t w_id, Read read);
+
+  // c_id of the customer in the middle of those with c_last ordered by c_first (spec 2.5.2.2), 0 if there is none
+  uint32_t findCustomer(uint32_t w_id, uint32_t d_id, const char* last);
+};
+}  // namespace TPCC
@@ -0,0 +1,328 @@
+#include "TPCCLog.hpp"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace TPCC
+{
+namespace
+{
+// record: [payload size u32][checksum u32][lsn u64][type u8][FunctionParams][line count u8][OrderLineRequest...]
+//         [queued lsn u64, DEFERRED_DELIVERY only]
+// the type is the FunctionID of an executed transaction or one of the log-only types of a deferred Delivery
+constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+// acknowledged and queued, not executed
+constexpr uint8_t QUEUED_DELIVERY = 0x80;
+// executed by the delivery worker, refers to its QUEUED_DELIVERY record
+constexpr uint8_t DEFERRED_DELIVERY = 0x81;
+
+uint32_t checksum(const uint8_t* data, size_t length)
+{
+  // FNV-1a, only has to detect a torn tail
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& buffer, const T& value)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void putRecord(std::vector<uint8_t>& buffer, uint64_t lsn, uint8_t type, const Transaction& transaction, const OrderLineRequest* lines)
+{
+  uint8_t lineCount = type == static_cast<uint8_t>(FunctionID::newOrder) ? transaction.params.newOrder.vecSize : 0;
+  size_t start = buffer.size();
+  buffer.resize(start + RECORD_HEADER_SIZE);
+  put(buffer, lsn);
+  put(buffer, type);
+  put(buffer, transaction.params);
+  put(buffer, lineCount);
+  if (lineCount != 0) {
+    const uint8_t* lineBytes = reinterpret_cast<const uint8_t*>(lines + transaction.firstLine);
+    buffer.insert(buffer.end(), lineBytes, lineBytes + lineCount * sizeof(OrderLineRequest));
+  }
+  if (type == DEFERRED_DELIVERY)
+    put(buffer, transaction.queuedLsn);
+
+  uint32_t size = buffer.size() - start - RECORD_HEADER_SIZE;
+  uint32_t sum = checksum(&buffer[start + RECORD_HEADER_SIZE], size);
+  memcpy(&buffer[start], &size, sizeof(size));
+  memcpy(&buffer[start + sizeof(size)], &sum, sizeof(sum));
+}
+
+void writeAll(int fd, const uint8_t* data, size_t length)
+{
+  while (length != 0) {
+    ssize_t n = write(fd, data, length);
+    if (n == -1) {
+      if (errno == EINTR)
+        continue;
+      perror("write(log)");
+      exit(EXIT_FAILURE);
+    }
+    data += n;
+    length -= n;
+  }
+}
+
+void sync(int fd)
+{
+  if (fdatasync(fd) == -1) {
+    perror("fdatasync(log)");
+    exit(EXIT_FAILURE);
+  }
+}
+}  // namespace
+
+void LogWriter::append(Transaction* const* transactions, size_t count, const OrderLineRequest* lines)
+{
+  {
+    // the LSNs are taken under the latch the log thread swaps the buffer with, so they are flushed together
+    std::lock_guard<std::mutex> guard(latch);
+    uint64_t first = log.nextLsn.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+      const Transaction& transaction = *transactions[i];
+      bool deferred = transaction.funcID == FunctionID::delivery && transaction.queuedLsn != 0;
+      putRecord(buffer, first + i, deferred ? DEFERRED_DELIVERY : static_cast<uint8_t>(transaction.funcID), transaction, lines);
+    }
+    ranges.emplace_back(first, first + count);
+  }
+  log.notify();
+}
+
+void LogWriter::appendQueued(Transaction* const* transactions, size_t count)
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    uint64_t first = log.nextLsn.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+      transactions[i]->queuedLsn = first + i;
+      putRecord(buffer, first + i, QUEUED_DELIVERY, *transactions[i], nullptr);
+    }
+    ranges.emplace_back(first, first + count);
+  }
+  log.notify();
+}
+
+uint64_t LogWriter::getLastLsn() const
+{
+  return log.nextLsn.load(std::memory_order_relaxed) - 1;
+}
+
+RedoLog::RedoLog(const std::string& path) : path(path) {}
+
+RedoLog::~RedoLog()
+{
+  if (thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(latch);
+      stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+  }
+  if (fd != -1)
+    close(fd);
+}
+
+size_t RedoLog::recover(Database& database)
+{
+  std::vector<uint8_t> data;
+  int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in != -1) {
+    uint8_t chunk[1 << 16];
+    ssize_t n;
+    while ((n = read(in, chunk, sizeof(chunk))) > 0)
+      data.insert(data.end(), chunk, chunk + n);
+    if (n == -1) {
+      perror("read(log)");
+      exit(EXIT_FAILURE);
+    }
+    close(in);
+  } else if (errno != ENOENT) {
+    perror("open(log)");
+    exit(EXIT_FAILURE);
+  }
+
+  // records up to the first torn or corrupt one, they are in flush order and are sorted by LSN below
+  struct Record {
+    uint64_t lsn;
+    size_t offset;
+    size_t size;
+  };
+  std::vector<Record> records;
+  for (size_t pos = 0; pos + RECORD_HEADER_SIZE <= data.size();) {
+    uint32_t size, sum;
+    memcpy(&size, &data[pos], sizeof(size));
+    memcpy(&sum, &data[pos + sizeof(size)], sizeof(sum));
+    size_t payload = pos + RECORD_HEADER_SIZE;
+    if (size < sizeof(uint64_t) || payload + size > data.size() || checksum(&data[payload], size) != sum)
+      break;
+    uint64_t lsn;
+    memcpy(&lsn, &data[payload], sizeof(lsn));
+    records.push_back({lsn, pos, RECORD_HEADER_SIZE + size});
+    pos = payload + size;
+  }
+  std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.lsn < b.lsn; });
+
+  // replay the gapless prefix, records behind a gap were never acknowledged
+  Executor executor(database);
+  std::string tmpPath = path + ".tmp";
+  int out = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (out == -1) {
+    perror("open(log)");
+    exit(EXIT_FAILURE);
+  }
+  // records up to the LSN of a loaded snapshot are in its tables already and are dropped from the log
+  std::vector<uint8_t> compacted;
+  uint64_t snapshotLsn = database.getSnapshotLsn();
+  uint64_t lastLsn = snapshotLsn;
+  size_t replayed = 0;
+  // queued Deliveries without an execution record by queued LSN, a snapshot does not contain them either
+  std::map<uint64_t, FunctionParams> queued;
+  for (const Record& record : records) {
+    bool inSnapshot = record.lsn <= snapshotLsn;
+    if (!inSnapshot && record.lsn != lastLsn + 1)
+      break;
+    const uint8_t* pos = &data[record.offset + RECORD_HEADER_SIZE + sizeof(uint64_t)];
+    uint8_t type = *pos++;
+    Transaction transaction{};
+    transaction.funcID = static_cast<FunctionID>(type);
+    transaction.code = ResponseCode::ok;
+    memcpy(&transaction.params, pos, sizeof(transaction.params));
+    pos += sizeof(transaction.params);
+    uint8_t lineCount = *pos++;
+    std::vector<OrderLineRequest> lines(lineCount);
+    memcpy(lines.data(), pos, lineCount * sizeof(OrderLineRequest));
+    pos += lineCount * sizeof(OrderLineRequest);
+    if (type == QUEUED_DELIVERY) {
+      queued.emplace(record.lsn, transaction.params);
+    } else {
+      if (type == DEFERRED_DELIVERY) {
+        transaction.funcID = FunctionID::delivery;
+        memcpy(&transaction.queuedLsn, pos, sizeof(transaction.queuedLsn));
+        queued.erase(transaction.queuedLsn);
+      }
+      if (!inSnapshot) {
+        Transaction* group[] = {&transaction};
+        executor.run(transaction.funcID, group, 1, lines.data());
+        replayed++;
+      }
+    }
+    if (inSnapshot)
+      continue;
+
+    compacted.insert(compacted.end(), &data[record.offset], &data[record.offset] + record.size);
+    lastLsn = record.lsn;
+  }
+  // the worker did not get to these before the server stopped, they are executed now and logged as if it had
+  for (const auto& [queuedLsn, params] : queued) {
+    Transaction transaction{};
+    transaction.funcID = FunctionID::delivery;
+    transaction.code = ResponseCode::ok;
+    transaction.params = params;
+    transaction.queuedLsn = queuedLsn;
+    Transaction* group[] = {&transaction};
+    executor.run(FunctionID::delivery, group, 1, nullptr);
+    putRecord(compacted, ++lastLsn, DEFERRED_DELIVERY, transaction, nullptr);
+    replayed++;
+  }
+  // the log is rewritten in LSN order without the torn tail, so new records continue right behind the replayed ones
+  writeAll(out, compacted.data(), compacted.size());
+  sync(out);
+  close(out);
+  if (rename(tmpPath.c_str(), path.c_str()) == -1) {
+    perror("rename(log)");
+    exit(EXIT_FAILURE);
+  }
+
+  nextLsn = lastLsn + 1;
+  durableLsn = lastLsn;
+  return replayed;
+}
+
+void RedoLog::start()
+{
+  if ((fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) == -1) {
+    perror("open(log)");
+    exit(EXIT_FAILURE);
+  }
+  thread = std::thread(&RedoLog::run, this);
+}
+
+LogWriter& RedoLog::attach(int notifyFd)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  writers.push_back(std::make_unique<LogWriter>(*this, notifyFd));
+  return *writers.back();
+}
+
+void RedoLog::notify()
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    pending = true;
+  }
+  wakeup.notify_one();
+}
+
+void RedoLog::run()
+{
+  std::vector<uint8_t> data;
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  std::vector<int> notifyFds;
+
+  for (;;) {
+    // collect everything the reactor threads appended since the last flush
+    {
+      std::unique_lock<std::mutex> lock(latch);
+      wakeup.wait(lock, [&] { return pending || stopping; });
+      if (!pending)
+        return;
+      pending = false;
+      notifyFds.clear();
+      for (auto& writer : writers) {
+        std::lock_guard<std::mutex> guard(writer->latch);
+        data.insert(data.end(), writer->buffer.begin(), writer->buffer.end());
+        ranges.insert(ranges.end(), writer->ranges.begin(), writer->ranges.end());
+        writer->buffer.clear();
+        writer->ranges.clear();
+        if (writer->notifyFd != -1)
+          notifyFds.push_back(writer->notifyFd);
+      }
+    }
+    if (data.empty())
+      continue;
+
+    // group commit: one write and one fdatasync for all transactions that arrived while the last one ran
+    writeAll(fd, data.data(), data.size());
+    sync(fd);
+    data.clear();
+
+    uint64_t durable = durableLsn.load(std::memory_order_relaxed);
+    for (auto& range : ranges)
+      flushedRanges.emplace(range.first, range.second);
+    ranges.clear();
+    for (auto it = flushedRanges.begin(); it != flushedRanges.end() && it->first == durable + 1; it = flushedRanges.erase(it))
+      durable = it->second - 1;
+    durableLsn.store(durable, std::memory_order_release);
+
+    for (int notifyFd : notifyFds) {
+      if (eventfd_write(notifyFd, 1) == -1) {
+        perror("eventfd_write()");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+}
+}  // namespace TPCC
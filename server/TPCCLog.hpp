@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TPCCExecutor.hpp"
+
+namespace TPCC
+{
+class RedoLog;
+
+// log buffer of one reactor thread
+class LogWriter
+{
+ public:
+  LogWriter(RedoLog& log, int notifyFd) : log(log), notifyFd(notifyFd) {}
+
+  // give the transactions consecutive LSNs and append their records
+  void append(Transaction* const* transactions, size_t count, const OrderLineRequest* lines);
+  // record that deferred Deliveries were queued, their queuedLsn is set to the LSN of their record
+  void appendQueued(Transaction* const* transactions, size_t count);
+  // highest LSN handed out by any thread, a transaction that ran before this call read no later writes
+  uint64_t getLastLsn() const;
+
+ private:
+  friend class RedoLog;
+
+  RedoLog& log;
+  // eventfd the log thread writes to after a commit, -1 = none
+  int notifyFd;
+  std::mutex latch;
+  std::vector<uint8_t> buffer;
+  // LSN ranges [first, end) of the records in buffer
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+};
+
+// append-only redo log of the modifying transactions (NewOrder, Payment, Delivery)
+// records are logical: execution is deterministic, so replaying the parameters of every committed transaction in LSN
+// order on the initial population rebuilds the database. LSNs are taken while the warehouse latches are held, so
+// their order is the serialization order of conflicting transactions.
+// a deferred Delivery is logged twice: when it is queued, before it is acknowledged, and when the worker executes it.
+// Recovery replays the execution records in LSN order and executes the queued Deliveries that have none at the end,
+// as if the worker had caught up on its queue.
+// every reactor thread appends to its own LogWriter, the log thread writes all of them with a single fdatasync (group
+// commit) and publishes the LSN up to which every record is durable
+class RedoLog
+{
+ public:
+  explicit RedoLog(const std::string& path);
+  ~RedoLog();
+
+  // replay the log into the freshly populated or loaded database and rewrite it without a torn tail and without the
+  // records the snapshot contains, call before start
+  // returns the number of replayed transactions
+  size_t recover(Database& database);
+  void start();
+
+  // register a reactor thread, notifyFd becomes readable whenever the durable LSN advanced
+  // notifyFd = -1 for a thread that does not wait for its commits
+  LogWriter& attach(int notifyFd);
+
+  uint64_t getDurableLsn() const { return durableLsn.load(std::memory_order_acquire); }
+  // highest LSN handed out, while every warehouse latch is held all transactions up to it have been executed
+  uint64_t getLastLsn() const { return nextLsn.load(std::memory_order_relaxed) - 1; }
+
+ private:
+  std::string path;
+  int fd = -1;
+  std::atomic<uint64_t> nextLsn{1};
+  std::atomic<uint64_t> durableLsn{0};
+
+  std::mutex latch;
+  std::condition_variable wakeup;
+  bool pending = false;
+  bool stopping = false;
+  std::vector<std::unique_ptr<LogWriter>> writers;
+  // flushed LSN ranges that are not yet contiguous with durableLsn, because a thread took an LSN but was not
+  // included in the last flush
+  std::map<uint64_t, uint64_t> flushedRanges;
+  std::thread thread;
+
+  friend class LogWriter;
+
+  void run();
+  void notify();
+};
+}  // namespace TPCC
@@ -0,0 +1,72 @@
+#include "TPCCNameIndex.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include "TPCCDatabase.hpp"
+
+namespace TPCC
+{
+size_t CustomerNameIndex::hash(const char* last)
+{
+  uint64_t a, b;
+  memcpy(&a, last, sizeof(a));
+  memcpy(&b, last + sizeof(a), sizeof(b));
+  uint64_t h = (a * 0x9E3779B97F4A7C15ull) ^ (b * 0xC2B2AE3D27D4EB4Full);
+  h ^= h >> 29;
+  return (h * 0x94D049BB133111EBull) >> 32 & (SLOT_COUNT - 1);
+}
+
+bool CustomerNameIndex::equal(const Key& key, const char* last)
+{
+#ifdef __SSE2__
+  __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(key.bytes));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF;
+#else
+  return memcmp(key.bytes, last, LAST_NAME_LENGTH) == 0;
+#endif
+}
+
+void CustomerNameIndex::build(const Customer* customers)
+{
+  // c_ids ordered by (c_last, c_first), so every name is one contiguous group
+  ids.resize(CUSTOMERS_PER_DISTRICT);
+  for (uint32_t c_id = 1; c_id <= CUSTOMERS_PER_DISTRICT; c_id++)
+    ids[c_id - 1] = c_id;
+  std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) {
+    const Customer& x = customers[a - 1];
+    const Customer& y = customers[b - 1];
+    int order = memcmp(x.last, y.last, LAST_NAME_LENGTH);
+    return order != 0 ? order < 0 : memcmp(x.first, y.first, sizeof(x.first)) < 0;
+  });
+
+  keys.assign(SLOT_COUNT, Key{});
+  slots.assign(SLOT_COUNT, Slot{0, 0});
+  for (uint32_t begin = 0, end; begin < ids.size(); begin = end) {
+    const char* last = customers[ids[begin] - 1].last;
+    for (end = begin + 1; end < ids.size() && memcmp(customers[ids[end] - 1].last, last, LAST_NAME_LENGTH) == 0; end++)
+      ;
+    size_t slot = hash(last);
+    while (slots[slot].count != 0)
+      slot = (slot + 1) & (SLOT_COUNT - 1);
+    memcpy(keys[slot].bytes, last, LAST_NAME_LENGTH);
+    slots[slot] = {begin, end - begin};
+  }
+}
+
+NameMatches CustomerNameIndex::find(const char* last) const
+{
+  for (size_t slot = hash(last);; slot = (slot + 1) & (SLOT_COUNT - 1)) {
+    const Slot& s = slots[slot];
+    if (s.count == 0)
+      return {nullptr, 0};
+    if (equal(keys[slot], last))
+      return {&ids[s.first], s.count};
+  }
+}
+}  // namespace TPCC
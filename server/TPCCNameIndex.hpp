@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace TPCC
+{
+inline constexpr size_t LAST_NAME_LENGTH = 16;
+
+struct Customer;
+
+// c_ids of the customers sharing a c_last, ordered by c_first
+struct NameMatches {
+  const uint32_t* ids;
+  size_t count;
+};
+
+// secondary index (c_last -> customers) of one district
+// an open addressing hash table over the zero padded 16 byte c_last, a probe compares a key with one SSE compare.
+// Names never change after the population, so the index is built once and read without latching.
+class CustomerNameIndex
+{
+ public:
+  // customers are the CUSTOMERS_PER_DISTRICT rows of the district, c_id order
+  void build(const Customer* customers);
+
+  // last is zero padded to LAST_NAME_LENGTH, count = 0 if no customer has that name
+  NameMatches find(const char* last) const;
+
+ private:
+  // power of two, at least twice the 1000 distinct names of spec 4.3.2.3
+  static constexpr size_t SLOT_COUNT = 2048;
+
+  struct alignas(16) Key {
+    char bytes[LAST_NAME_LENGTH];
+  };
+  struct Slot {
+    uint32_t first;  // into ids
+    uint32_t count;  // 0 = empty
+  };
+
+  std::vector<Key> keys;
+  std::vector<Slot> slots;
+  // c_ids grouped by name, every group ordered by c_first
+  std::vector<uint32_t> ids;
+
+  static size_t hash(const char* last);
+  static bool equal(const Key& key, const char* last);
+};
+}  // namespace TPCC
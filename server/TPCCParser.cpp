@@ -1,9 +1,33 @@
 #include "TPCCParser.hpp"
 
+#include "AdmissionControl.hpp"
+#include "TPCCBatch.hpp"
+
 namespace TPCC
 {
 std::atomic<uint64_t> eventCounter = 0;
 
+Parser::Parser()
+{
+  // vecSize is a single byte, so the vectors never have to grow beyond this
+  vParams.lineNumbers.reserve(UINT8_MAX);
+  vParams.supwares.reserve(UINT8_MAX);
+  vParams.itemids.reserve(UINT8_MAX);
+  vParams.qtys.reserve(UINT8_MAX);
+}
+
+void Parser::reset()
+{
+  frame.reset();
+  setUpNewPaket();
+}
+
+void Parser::attach(std::vector<uint8_t>& outBuffer, HandlerContext& context)
+{
+  this->outBuffer = &outBuffer;
+  this->context = &context;
+}
+
 void Parser::parse(const uint8_t* data, size_t length)
 {
   size_t i = 0;
@@ -36,12 +60,26 @@ void Parser::parse(const uint8_t* data, size_t length)
       case FunctionID::paymentByName:
         parsePaymentByName(data[i]);
         break;
+      case FunctionID::batch:
+        parseBatch(data[i]);
+        break;
     }
     byteIndex++;
     i++;
   }
 }
 
+void Parser::runTPCCFunction()
+{
+  Framing framing = frame.next();
+  if (!context->admission.admit(funcID)) {
+    rejectedCounter++;
+    context->batch.reject(funcID, *outBuffer, context->connection, context->readTime, framing);
+    return;
+  }
+  context->batch.add(funcID, params, vParams, *outBuffer, context->connection, context->readTime, framing);
+}
+
 inline void Parser::setUpNewPaket()
 {
   fieldIndex = 0;
@@ -252,6 +290,13 @@ inline void Parser::parsePaymentByName(uint8_t data)
   }
 }
 
+inline void Parser::parseBatch(uint8_t data)
+{
+  // the requests of the frame follow as usual
+  frame.open(data);
+  setUpNewPaket();
+}
+
 inline void Parser::parse32(uint32_t& dest, uint8_t data)
 {
   parse32AndRun(dest, data, [&]() {
@@ -2,9 +2,12 @@
 #include <endian.h>
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
-#include "ProtocolParser.hpp"
+#include "HandlerContext.hpp"
+#include "TPCC/Response.hpp"
 
 namespace TPCC
 {
@@ -18,9 +21,49 @@ enum class FunctionID : uint8_t {
   orderStatusId = 4,
   orderStatusName = 5,
   paymentById = 6,
-  paymentByName = 7
+  paymentByName = 7,
+  // header of a batch frame, see Response.hpp
+  batch = BATCH_FRAME_ID
 };
 
+// where the response of a transaction goes in a batched response frame
+struct Framing {
+  // part of a batch frame, answered by an entry of the frame's response instead of a response of its own
+  bool framed = false;
+  // transactions in the frame if this is its first one, 0 otherwise
+  uint8_t frameSize = 0;
+};
+
+// the batch frame a handler is reading requests of
+class BatchFrame
+{
+ public:
+  // a frame of count requests starts, the header of a frame inside a frame is ignored
+  void open(uint8_t count)
+  {
+    if (remaining == 0)
+      size = remaining = count;
+  }
+
+  // framing of the next complete request
+  Framing next()
+  {
+    if (remaining == 0)
+      return {};
+    Framing framing{true, remaining == size ? size : uint8_t(0)};
+    remaining--;
+    return framing;
+  }
+
+  void reset() { remaining = 0; }
+
+ private:
+  uint8_t size = 0;
+  uint8_t remaining = 0;
+};
+
+class AdmissionControl;
+
 union FunctionParams {
   struct NewOrder {
     uint64_t timestamp;
@@ -80,10 +123,15 @@ struct VectorParams {
   std::vector<int32_t> qtys;
 };
 
-class Parser : Net::ProtocolParser
+class Parser
 {
  public:
+  Parser();
   void parse(const uint8_t* data, size_t length);
+  // drop any partially parsed paket
+  void reset();
+  // set where responses are appended to, complete requests go to the admission control and batch of the thread
+  void attach(std::vector<uint8_t>& outBuffer, HandlerContext& context);
 
  private:
   size_t fieldIndex = 0;
@@ -92,8 +140,11 @@ class Parser : Net::ProtocolParser
   FunctionID funcID = FunctionID::notSet;
   FunctionParams params;
   VectorParams vParams;
+  BatchFrame frame;
+  std::vector<uint8_t>* outBuffer = nullptr;
+  HandlerContext* context = nullptr;
 
-  void runTPCCFunction() { eventCounter++; }  // TODO tpcc function calls
+  void runTPCCFunction();
 
   void setUpNewPaket();
 
@@ -104,6 +155,7 @@ class Parser : Net::ProtocolParser
   void parseOrderStatusName(uint8_t data);
   void parsePaymentById(uint8_t data);
   void parsePaymentByName(uint8_t data);
+  void parseBatch(uint8_t data);
 
   void parse32(uint32_t& dest, uint8_t data);
   void parse64(uint64_t& dest, uint8_t data);
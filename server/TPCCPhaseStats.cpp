@@ -0,0 +1,53 @@
+#include "TPCCPhaseStats.hpp"
+
+#include <chrono>
+
+namespace TPCC
+{
+uint64_t nowNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PhaseStats::Durations PhaseStats::durations(const Timing& timing, uint64_t sent)
+{
+  return {timing.parsed - timing.read, timing.executionStart - timing.parsed, timing.executionEnd - timing.executionStart,
+          sent - timing.executionEnd, sent - timing.read};
+}
+
+void PhaseStats::record(FunctionID funcID, const Durations& durations)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  auto& function = histograms[static_cast<uint8_t>(funcID)];
+  for (size_t p = 0; p < PHASE_COUNT; p++)
+    function[p].record(durations[p]);
+}
+
+void PhaseStats::moveTo(PhaseStats& other)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  for (size_t f = 0; f < FUNCTION_COUNT; f++) {
+    for (size_t p = 0; p < PHASE_COUNT; p++) {
+      other.histograms[f][p].merge(histograms[f][p]);
+      histograms[f][p].reset();
+    }
+  }
+}
+
+void PhaseStats::print(std::ostream& out) const
+{
+  static const char* const functionNames[] = {"", "NewOrder", "Delivery", "StockLevel", "OrderStatusId", "OrderStatusName", "PaymentById", "PaymentByName"};
+  static const char* const phaseNames[] = {"parse", "queue", "execute", "commit", "total"};
+  for (size_t f = 1; f < FUNCTION_COUNT; f++) {
+    if (histograms[f][0].count() == 0)
+      continue;
+    out << functionNames[f] << " " << histograms[f][0].count() << ":";
+    for (size_t p = 0; p < PHASE_COUNT; p++) {
+      const Stats::Histogram& histogram = histograms[f][p];
+      out << " " << phaseNames[p] << " " << histogram.percentile(0.5) / 1000.0 << "/" << histogram.percentile(0.99) / 1000.0 << "/"
+          << histogram.max() / 1000.0;
+    }
+    out << "\n";
+  }
+}
+}  // namespace TPCC
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+#include "Stats/Histogram.hpp"
+#include "TPCCParser.hpp"
+
+namespace TPCC
+{
+// where a transaction spends its time on the server, measured from the read() that completed its request
+enum class Phase : uint8_t {
+  parse,    // read completed -> request parsed
+  queue,    // parsed -> its group starts executing, waiting for the batch to fill or the round to end
+  execute,  // execution of its group, latching included
+  commit,   // executed -> response handed to the socket, includes waiting for the redo log
+  total     // read completed -> response handed to the socket
+};
+inline constexpr size_t PHASE_COUNT = 5;
+inline constexpr size_t FUNCTION_COUNT = 8;
+
+// steady clock timestamps in ns of one transaction, read = 0 if timing is off
+struct Timing {
+  uint64_t read;
+  uint64_t parsed;
+  uint64_t executionStart;
+  uint64_t executionEnd;
+};
+
+uint64_t nowNanos();
+
+// per FunctionID histograms of the phase durations, one instance per reactor thread
+// the thread records, the reporting thread merges and resets under the latch once per interval
+class PhaseStats
+{
+ public:
+  using Durations = std::array<uint64_t, PHASE_COUNT>;
+
+  static Durations durations(const Timing& timing, uint64_t sent);
+
+  void record(FunctionID funcID, const Durations& durations);
+  // add the histograms to other and reset them
+  void moveTo(PhaseStats& other);
+
+  // p50, p99 and max in us of every phase of every FunctionID that was executed
+  void print(std::ostream& out) const;
+
+ private:
+  std::mutex latch;
+  std::array<std::array<Stats::Histogram, PHASE_COUNT>, FUNCTION_COUNT> histograms;
+};
+}  // namespace TPCC
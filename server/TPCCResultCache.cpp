@@ -0,0 +1,57 @@
+#include "TPCCResultCache.hpp"
+
+namespace TPCC
+{
+std::array<CacheCounters, CACHED_FUNCTION_COUNT> cacheCounters;
+
+ResultCache::ResultCache(size_t size)
+{
+  if (size == 0)
+    return;
+  size_t capacity = 1;
+  while (capacity < size)
+    capacity *= 2;
+  entries.assign(capacity, Entry{{0, 0, 0}, 0, 0});
+  mask = capacity - 1;
+}
+
+ResultCache::Entry& ResultCache::slot(uint32_t a, uint32_t b, uint32_t c)
+{
+  uint64_t h = (a * 0x9E3779B97F4A7C15ull) ^ (b * 0xC2B2AE3D27D4EB4Full) ^ (c * 0x165667B19E3779F9ull);
+  return entries[(h ^ h >> 32) & mask];
+}
+
+bool ResultCache::find(uint32_t a, uint32_t b, uint32_t c, uint64_t version, uint32_t& result)
+{
+  if (entries.empty())
+    return false;
+  const Entry& entry = slot(a, b, c);
+  if (entry.key[0] != a || entry.key[1] != b || entry.key[2] != c || entry.version != version)
+    return false;
+  result = entry.result;
+  hits++;
+  savedNanos += averageMissNanos;
+  return true;
+}
+
+void ResultCache::insert(uint32_t a, uint32_t b, uint32_t c, uint64_t version, uint32_t result)
+{
+  slot(a, b, c) = Entry{{a, b, c}, result, version};
+}
+
+void ResultCache::recordMiss(uint64_t nanos)
+{
+  misses++;
+  averageMissNanos = averageMissNanos == 0 ? nanos : (averageMissNanos * 7 + nanos) / 8;
+}
+
+void ResultCache::publish(CacheCounters& counters)
+{
+  if (hits == 0 && misses == 0)
+    return;
+  counters.hits.fetch_add(hits, std::memory_order_relaxed);
+  counters.misses.fetch_add(misses, std::memory_order_relaxed);
+  counters.savedNanos.fetch_add(savedNanos, std::memory_order_relaxed);
+  hits = misses = savedNanos = 0;
+}
+}  // namespace TPCC
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace TPCC
+{
+// read-only transactions whose results can be cached
+enum class CachedFunction : uint8_t { stockLevel, orderStatus };
+inline constexpr size_t CACHED_FUNCTION_COUNT = 2;
+
+struct CacheCounters {
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  // hits times the average execution time of a miss
+  std::atomic<uint64_t> savedNanos{0};
+};
+// summed over all threads, indexed by CachedFunction
+extern std::array<CacheCounters, CACHED_FUNCTION_COUNT> cacheCounters;
+
+// direct mapped cache of the results of one read-only transaction type, one instance per executor
+// an entry is valid as long as the version it was stored with matches the current version of the rows it was computed
+// from, the writing transactions bump those versions, so nothing has to be invalidated explicitly
+class ResultCache
+{
+ public:
+  struct Config {
+    // indexed by CachedFunction
+    std::array<bool, CACHED_FUNCTION_COUNT> enabled = {};
+    // entries per thread and transaction type, rounded up to a power of two
+    size_t size = 4096;
+  };
+
+  // size = 0 disables the cache
+  explicit ResultCache(size_t size);
+
+  bool enabled() const { return !entries.empty(); }
+  // keys are 3 ids, a != 0
+  bool find(uint32_t a, uint32_t b, uint32_t c, uint64_t version, uint32_t& result);
+  void insert(uint32_t a, uint32_t b, uint32_t c, uint64_t version, uint32_t result);
+
+  // called for every miss with the time it took to execute
+  void recordMiss(uint64_t nanos);
+  // add the counts since the last call to counters
+  void publish(CacheCounters& counters);
+
+ private:
+  struct Entry {
+    uint32_t key[3];  // key[0] = 0 = empty
+    uint32_t result;
+    uint64_t version;
+  };
+
+  std::vector<Entry> entries;
+  size_t mask = 0;
+
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // exponentially weighted moving average of the execution time of a miss
+  uint64_t averageMissNanos = 0;
+  uint64_t savedNanos = 0;
+
+  Entry& slot(uint32_t a, uint32_t b, uint32_t c);
+};
+}  // namespace TPCC
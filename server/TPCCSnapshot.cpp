@@ -0,0 +1,150 @@
+#include "TPCCSnapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace TPCC
+{
+namespace
+{
+constexpr char SNAPSHOT_MAGIC[8] = {'T', 'P', 'C', 'C', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+// sections start on a page boundary of the mapping
+constexpr uint64_t SECTION_ALIGNMENT = 4096;
+
+uint64_t align(uint64_t offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+void writeAll(int fd, const void* data, size_t length, uint64_t offset)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (length != 0) {
+    ssize_t n = pwrite(fd, bytes, length, offset);
+    if (n == -1) {
+      if (errno == EINTR)
+        continue;
+      perror("pwrite(snapshot)");
+      exit(EXIT_FAILURE);
+    }
+    bytes += n;
+    offset += n;
+    length -= n;
+  }
+}
+
+[[noreturn]] void corrupt(const std::string& path, const char* reason)
+{
+  std::cerr << "snapshot " << path << ": " << reason << "\n";
+  exit(EXIT_FAILURE);
+}
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint32_t warehouseCount, uint64_t lsn, size_t sectionCount)
+    : path(path), tmpPath(path + ".tmp"), header{}
+{
+  if ((fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+    perror("open(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.warehouseCount = warehouseCount;
+  header.lsn = lsn;
+  header.sectionCount = sectionCount;
+  sections.reserve(sectionCount);
+  end = align(sizeof(SnapshotHeader) + sectionCount * sizeof(SnapshotSection));
+}
+
+void SnapshotWriter::add(const void* rows, size_t rowCount, size_t rowSize)
+{
+  sections.push_back({end, rowCount, rowSize});
+  writeAll(fd, rows, rowCount * rowSize, end);
+  end = align(end + rowCount * rowSize);
+}
+
+void SnapshotWriter::finish()
+{
+  if (sections.size() != header.sectionCount)
+    corrupt(path, "section count does not match");
+  writeAll(fd, &header, sizeof(header), 0);
+  writeAll(fd, sections.data(), sections.size() * sizeof(SnapshotSection), sizeof(header));
+  // the last section may end before its alignment, the mapping covers the whole file
+  if (ftruncate(fd, end) == -1) {
+    perror("ftruncate(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  if (fdatasync(fd) == -1) {
+    perror("fdatasync(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+  if (rename(tmpPath.c_str(), path.c_str()) == -1) {
+    perror("rename(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+}
+
+SnapshotMapping::~SnapshotMapping()
+{
+  if (base)
+    munmap(base, size);
+}
+
+bool SnapshotMapping::open(const std::string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    if (errno == ENOENT)
+      return false;
+    perror("open(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  this->path = path;
+  struct stat status;
+  if (fstat(fd, &status) == -1) {
+    perror("fstat(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  size = status.st_size;
+  if (size < sizeof(SnapshotHeader))
+    corrupt(path, "truncated");
+  // private and writable: transactions update the rows in place, the file is never written through the mapping
+  void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap(snapshot)");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+  base = static_cast<uint8_t*>(p);
+
+  const SnapshotHeader& header = getHeader();
+  if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION)
+    corrupt(path, "not a snapshot of this version");
+  if (sizeof(SnapshotHeader) + header.sectionCount * sizeof(SnapshotSection) > size)
+    corrupt(path, "truncated");
+  const SnapshotSection* sections = reinterpret_cast<const SnapshotSection*>(base + sizeof(SnapshotHeader));
+  for (size_t s = 0; s < header.sectionCount; s++) {
+    if (sections[s].offset % SECTION_ALIGNMENT != 0 || sections[s].offset + sections[s].rowCount * sections[s].rowSize > size)
+      corrupt(path, "truncated");
+  }
+  return true;
+}
+
+const SnapshotSection& SnapshotMapping::nextSection(size_t rowSize)
+{
+  const SnapshotSection* sections = reinterpret_cast<const SnapshotSection*>(base + sizeof(SnapshotHeader));
+  if (next == getHeader().sectionCount || sections[next].rowSize != rowSize)
+    corrupt(path, "row layout does not match this server");
+  return sections[next++];
+}
+}  // namespace TPCC
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TPCCTable.hpp"
+
+namespace TPCC
+{
+// binary image of all tables of a database, see Database::save and Database::load
+// layout: header, section table, then the rows of every table at a page aligned offset, in the order they were added.
+// Rows are stored as they are in memory, so a snapshot is only read by a server built with the same row layout.
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t warehouseCount;
+  // last LSN of the redo log whose transaction is contained, 0 = initial population
+  uint64_t lsn;
+  uint64_t sectionCount;
+};
+
+struct SnapshotSection {
+  uint64_t offset;
+  uint64_t rowCount;
+  uint64_t rowSize;
+};
+
+// writes a snapshot to a temporary file and renames it over path once it is durable, so path always holds a
+// complete snapshot
+class SnapshotWriter
+{
+ public:
+  SnapshotWriter(const std::string& path, uint32_t warehouseCount, uint64_t lsn, size_t sectionCount);
+
+  template <typename T>
+  void add(const Table<T>& table)
+  {
+    add(table.data(), table.size(), sizeof(T));
+  }
+  void finish();
+
+ private:
+  std::string path;
+  std::string tmpPath;
+  int fd;
+  SnapshotHeader header;
+  std::vector<SnapshotSection> sections;
+  uint64_t end;
+
+  void add(const void* rows, size_t rowCount, size_t rowSize);
+};
+
+// a snapshot mapped copy-on-write, pages are read when first touched and copied when first written
+// tables are views into the mapping, it has to outlive them
+class SnapshotMapping
+{
+ public:
+  SnapshotMapping() = default;
+  ~SnapshotMapping();
+  SnapshotMapping(const SnapshotMapping&) = delete;
+  SnapshotMapping& operator=(const SnapshotMapping&) = delete;
+
+  // false if there is no file at path
+  bool open(const std::string& path);
+  const SnapshotHeader& getHeader() const { return *reinterpret_cast<const SnapshotHeader*>(base); }
+  size_t getSize() const { return size; }
+
+  // let table view the rows of the next section
+  template <typename T>
+  void view(Table<T>& table)
+  {
+    const SnapshotSection& section = nextSection(sizeof(T));
+    table.view(reinterpret_cast<T*>(base + section.offset), section.rowCount);
+  }
+
+ private:
+  std::string path;
+  uint8_t* base = nullptr;
+  size_t size = 0;
+  size_t next = 0;
+
+  const SnapshotSection& nextSection(size_t rowSize);
+};
+}  // namespace TPCC
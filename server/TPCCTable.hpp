@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Sys/HugePages.hpp"
+
+namespace TPCC
+{
+// storage of tables and order line heaps, a growable array of trivially copyable rows
+// the big arrays are mapped with huge pages to keep TLB misses down on the randomly accessed rows. A table can also be
+// a view of rows in a mapped snapshot, it is copied to its own storage the first time it has to grow.
+// Readers that do not hold the latch of the table get its rows with readRows while a writer appends: storage outgrown
+// by the table is kept until the table is destroyed, so rows once handed out stay readable.
+template <typename T>
+class Table
+{
+  static_assert(std::is_trivially_copyable_v<T>, "rows are copied and written to snapshots as bytes");
+
+ public:
+  Table() = default;
+  // count zeroed rows
+  explicit Table(size_t count) { resize(count); }
+  ~Table() { release(); }
+  Table(Table&& other) noexcept { *this = std::move(other); }
+  Table& operator=(Table&& other) noexcept
+  {
+    release();
+    retired = std::move(other.retired);
+    rows = std::exchange(other.rows, nullptr);
+    rowCount = std::exchange(other.rowCount, 0);
+    capacity = std::exchange(other.capacity, 0);
+    owned = std::exchange(other.owned, true);
+    return *this;
+  }
+  Table(const Table&) = delete;
+  Table& operator=(const Table&) = delete;
+
+  // rows belong to a mapping that outlives the table
+  void view(T* mapped, size_t count)
+  {
+    release();
+    rows = mapped;
+    rowCount = capacity = count;
+    owned = false;
+  }
+
+  size_t size() const { return rowCount; }
+  // rows [0, count) of the returned pointer, consistent with each other even while a writer appends
+  const T* readRows(size_t& count) const
+  {
+    count = __atomic_load_n(&rowCount, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&rows, __ATOMIC_ACQUIRE);
+  }
+  T* data() { return rows; }
+  const T* data() const { return rows; }
+  T& operator[](size_t i) { return rows[i]; }
+  const T& operator[](size_t i) const { return rows[i]; }
+  T* begin() { return rows; }
+  T* end() { return rows + rowCount; }
+  const T* begin() const { return rows; }
+  const T* end() const { return rows + rowCount; }
+
+  void reserve(size_t n)
+  {
+    if (n <= capacity)
+      return;
+    T* grown = Sys::HugePageAllocator<T>().allocate(n);
+    if (rowCount != 0)
+      memcpy(static_cast<void*>(grown), rows, rowCount * sizeof(T));
+    if (owned && rows)
+      retired.emplace_back(rows, capacity);
+    // the copied rows are published before the count can grow past the old capacity
+    __atomic_store_n(&rows, grown, __ATOMIC_RELEASE);
+    capacity = n;
+    owned = true;
+  }
+
+  // shrinks or appends zeroed rows
+  void resize(size_t n)
+  {
+    reserve(n);
+    if (n > rowCount)
+      memset(static_cast<void*>(rows + rowCount), 0, (n - rowCount) * sizeof(T));
+    __atomic_store_n(&rowCount, n, __ATOMIC_RELEASE);
+  }
+
+  void push_back(const T& row)
+  {
+    if (rowCount == capacity)
+      reserve(capacity ? capacity * 2 : 16);
+    rows[rowCount] = row;
+    __atomic_store_n(&rowCount, rowCount + 1, __ATOMIC_RELEASE);
+  }
+
+ private:
+  T* rows = nullptr;
+  size_t rowCount = 0;
+  size_t capacity = 0;
+  bool owned = true;
+  // outgrown storage and its capacity
+  std::vector<std::pair<T*, size_t>> retired;
+
+  void release()
+  {
+    for (auto& storage : retired)
+      Sys::HugePageAllocator<T>().deallocate(storage.first, storage.second);
+    retired.clear();
+    if (owned && rows)
+      Sys::HugePageAllocator<T>().deallocate(rows, capacity);
+    rows = nullptr;
+  }
+};
+}  // namespace TPCC
@@ -1,21 +1,244 @@
+#include <getopt.h>
+
+#include <algorithm>
 #include <iostream>
 #include <string>
 
 #include "Server.hpp"
+#include "Sys/Affinity.hpp"
+
+static void printUsage(const char* name)
+{
+  std::cout << "Usage: " << name << " <port> <number of threads> <read buffer size> [options]\n"
+            << "Options:\n"
+            << "  --listen=<port>:<protocol>    also accept connections of protocol (tpcc, tpcc-coroutine, echo) on port\n"
+            << "  --warehouses=<n>              number of TPC-C warehouses to populate (default 1)\n"
+            << "  --load-threads=<n>            threads populating the database (default one per core)\n"
+            << "  --batch-size=<n>              transactions a thread executes together, 1 = no batching (default 256)\n"
+            << "  --log=<path>                  redo log file, replayed at startup, responses wait for their commit\n"
+            << "  --snapshot=<path>             map the tables from this snapshot, or populate and write it if there is none,\n"
+            << "                                SIGUSR1 rewrites it with the current tables\n"
+            << "  --snapshot-on-exit            rewrite the snapshot on SIGINT and SIGTERM before exiting\n"
+            << "  --deferred-delivery=<n>       answer Deliveries when queued, a background worker executes them per warehouse,\n"
+            << "                                Deliveries beyond n waiting are rejected as busy\n"
+            << "  --result-cache=<list>         cache results of stock-level, order-status or both, comma separated\n"
+            << "  --result-cache-size=<n>       cached results per thread and transaction type (default 4096)\n"
+            << "  --phase-stats                 print per function id where requests spend their time in the server\n"
+            << "  --echo-timing                 append the server's phase durations in ns to every response\n"
+            << "  --huge-pages=<policy>         back tables and buffers with off, transparent or hugetlb pages (default transparent)\n"
+            << "  --memory-stats                print page faults and dTLB misses every interval\n"
+            << "  --read-budget=<bytes>         bytes read from one connection per turn, 0 = until EAGAIN (default 65536)\n"
+            << "  --no-admission                execute every request regardless of load\n"
+            << "  --admission-delay=<us>        turn waiting time per overload level, 0 = ignore (default 2000)\n"
+            << "  --admission-depth=<n>         ready list length per overload level, 0 = ignore (default 32)\n"
+            << "  --priority=<function id>:<p>  admission priority of a function id, admitted while p >= overload level (0-3)\n"
+            << "  --cores=<list>                pin reactor threads round-robin to cores, e.g. 0-7,16-23\n"
+            << "  --incoming-cpu                accept connections on the thread pinned to the core of their NIC queue\n"
+            << "  --busy-poll=<us>              spin on epoll_wait, block only after being idle this long\n"
+            << "  --socket-busy-poll=<us>       set SO_BUSY_POLL and SO_PREFER_BUSY_POLL on accepted sockets\n"
+            << "  --shm=<path>                  accept shared memory channels from local clients on this Unix socket\n"
+            << "  --shm-ring-size=<bytes>       capacity of each shared memory ring, power of two (default 1048576)\n"
+            << "  --backlog=<n>                 listen backlog (default 4096)\n"
+            << "  --accept-batch=<n>            connections accepted per wakeup (default 64)\n"
+            << "  --no-nodelay                  don't set TCP_NODELAY on accepted sockets\n"
+            << "  --quickack                    set TCP_QUICKACK on accepted sockets\n"
+            << "  --rcvbuf=<bytes>              SO_RCVBUF of accepted sockets\n"
+            << "  --sndbuf=<bytes>              SO_SNDBUF of accepted sockets\n";
+}
 
 int main(int argc, char* argv[])
 {
-  if (argc != 4) {
-    std::cout << "Usage: " << argv[0] << " <port> <number of threads> <read buffer size>" << std::endl;
+  Server::Config config;
+
+  static const struct option options[] = {{"listen", required_argument, nullptr, 'l'},
+                                          {"warehouses", required_argument, nullptr, 'w'},
+                                          {"load-threads", required_argument, nullptr, 'D'},
+                                          {"batch-size", required_argument, nullptr, 'B'},
+                                          {"log", required_argument, nullptr, 'g'},
+                                          {"snapshot", required_argument, nullptr, 'T'},
+                                          {"snapshot-on-exit", no_argument, nullptr, 'X'},
+                                          {"deferred-delivery", required_argument, nullptr, 'y'},
+                                          {"result-cache", required_argument, nullptr, 'C'},
+                                          {"result-cache-size", required_argument, nullptr, 'z'},
+                                          {"phase-stats", no_argument, nullptr, 'P'},
+                                          {"echo-timing", no_argument, nullptr, 'E'},
+                                          {"huge-pages", required_argument, nullptr, 'H'},
+                                          {"memory-stats", no_argument, nullptr, 'M'},
+                                          {"read-budget", required_argument, nullptr, 'b'},
+                                          {"no-admission", no_argument, nullptr, 'n'},
+                                          {"admission-delay", required_argument, nullptr, 'd'},
+                                          {"admission-depth", required_argument, nullptr, 'q'},
+                                          {"priority", required_argument, nullptr, 'p'},
+                                          {"cores", required_argument, nullptr, 'c'},
+                                          {"incoming-cpu", no_argument, nullptr, 'i'},
+                                          {"busy-poll", required_argument, nullptr, 's'},
+                                          {"socket-busy-poll", required_argument, nullptr, 'k'},
+                                          {"shm", required_argument, nullptr, 'm'},
+                                          {"shm-ring-size", required_argument, nullptr, 'r'},
+                                          {"backlog", required_argument, nullptr, 'L'},
+                                          {"accept-batch", required_argument, nullptr, 'A'},
+                                          {"no-nodelay", no_argument, nullptr, 'N'},
+                                          {"quickack", no_argument, nullptr, 'Q'},
+                                          {"rcvbuf", required_argument, nullptr, 'R'},
+                                          {"sndbuf", required_argument, nullptr, 'S'},
+                                          {nullptr, 0, nullptr, 0}};
+  try {
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, nullptr)) != -1) {
+      switch (opt) {
+        case 'l': {
+          std::string arg = optarg;
+          size_t sep = arg.find(':');
+          if (sep == std::string::npos)
+            throw std::invalid_argument("--listen expects <port>:<protocol>");
+          config.listeners.push_back({static_cast<uint16_t>(std::stoi(arg.substr(0, sep))), parseProtocol(arg.substr(sep + 1))});
+          break;
+        }
+        case 'w':
+          config.warehouseCount = std::stoul(optarg);
+          if (config.warehouseCount == 0)
+            throw std::invalid_argument("--warehouses must be at least 1");
+          break;
+        case 'D':
+          config.loadThreads = std::stoul(optarg);
+          break;
+        case 'B':
+          config.batchSize = std::max<size_t>(1, std::stoul(optarg));
+          break;
+        case 'g':
+          config.logPath = optarg;
+          break;
+        case 'T':
+          config.snapshotPath = optarg;
+          break;
+        case 'X':
+          config.snapshotOnExit = true;
+          break;
+        case 'y':
+          config.deliveryQueueSize = std::stoul(optarg);
+          if (config.deliveryQueueSize == 0)
+            throw std::invalid_argument("--deferred-delivery expects at least 1");
+          break;
+        case 'C': {
+          std::string list = optarg;
+          for (size_t begin = 0, end; begin <= list.size(); begin = end + 1) {
+            end = std::min(list.find(',', begin), list.size());
+            std::string name = list.substr(begin, end - begin);
+            if (name == "stock-level")
+              config.resultCache.enabled[static_cast<size_t>(TPCC::CachedFunction::stockLevel)] = true;
+            else if (name == "order-status")
+              config.resultCache.enabled[static_cast<size_t>(TPCC::CachedFunction::orderStatus)] = true;
+            else
+              throw std::invalid_argument("--result-cache expects stock-level and/or order-status");
+          }
+          break;
+        }
+        case 'z':
+          config.resultCache.size = std::stoul(optarg);
+          break;
+        case 'P':
+          config.phaseStats = true;
+          break;
+        case 'E':
+          config.echoTiming = true;
+          break;
+        case 'H': {
+          std::string policy = optarg;
+          if (policy == "off")
+            config.hugePages = Sys::HugePagePolicy::off;
+          else if (policy == "transparent")
+            config.hugePages = Sys::HugePagePolicy::transparent;
+          else if (policy == "hugetlb")
+            config.hugePages = Sys::HugePagePolicy::hugetlb;
+          else
+            throw std::invalid_argument("--huge-pages expects off, transparent or hugetlb");
+          break;
+        }
+        case 'M':
+          config.memoryStats = true;
+          break;
+        case 'b':
+          config.readBudget = std::stoul(optarg);
+          break;
+        case 'n':
+          config.admission.enabled = false;
+          break;
+        case 'd':
+          config.admission.targetDelay = std::chrono::microseconds(std::stoul(optarg));
+          break;
+        case 'q':
+          config.admission.targetQueueDepth = std::stoul(optarg);
+          break;
+        case 'p': {
+          std::string arg = optarg;
+          size_t sep = arg.find(':');
+          size_t funcID = std::stoul(arg.substr(0, sep));
+          if (sep == std::string::npos || funcID >= config.admission.priorities.size())
+            throw std::invalid_argument("--priority expects <function id>:<priority>");
+          config.admission.priorities[funcID] = std::stoul(arg.substr(sep + 1));
+          break;
+        }
+        case 'c':
+          config.cores = Sys::parseCoreList(optarg);
+          break;
+        case 'i':
+          config.incomingCpu = true;
+          break;
+        case 's':
+          config.busyPollIdle = std::chrono::microseconds(std::stoul(optarg));
+          break;
+        case 'k':
+          config.socketBusyPoll = std::stoi(optarg);
+          break;
+        case 'm':
+          config.shmPath = optarg;
+          break;
+        case 'r':
+          config.shmRingSize = std::stoul(optarg);
+          if (config.shmRingSize == 0 || (config.shmRingSize & (config.shmRingSize - 1)))
+            throw std::invalid_argument("--shm-ring-size must be a power of two");
+          break;
+        case 'L':
+          config.listenBacklog = std::stoi(optarg);
+          break;
+        case 'A':
+          config.acceptBatch = std::stoi(optarg);
+          break;
+        case 'N':
+          config.noDelay = false;
+          break;
+        case 'Q':
+          config.quickAck = true;
+          break;
+        case 'R':
+          config.receiveBufferSize = std::stoi(optarg);
+          break;
+        case 'S':
+          config.sendBufferSize = std::stoi(optarg);
+          break;
+        default:
+          printUsage(argv[0]);
+          return 1;
+      }
+    }
+
+    if (config.snapshotOnExit && config.snapshotPath.empty())
+      throw std::invalid_argument("--snapshot-on-exit requires --snapshot");
+    if (argc - optind != 3) {
+      printUsage(argv[0]);
+      return 1;
+    }
+    config.listeners.insert(config.listeners.begin(), {static_cast<uint16_t>(std::stoi(argv[optind])), Protocol::tpcc});
+    config.threadCount = std::stoi(argv[optind + 1]);
+    config.bufferSize = std::stoi(argv[optind + 2]);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    printUsage(argv[0]);
     return 1;
   }
 
-  uint16_t port = std::stoi(argv[1]);
-  int threads = std::stoi(argv[2]);
-  size_t bufferSize = std::stoi(argv[3]);
-
   Server server;
-  server.init(port, bufferSize);
-  server.run(threads);
+  server.init(config);
+  server.run();
   return 0;
-}
\ No newline at end of file
+}
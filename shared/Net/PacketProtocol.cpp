@@ -2,14 +2,74 @@
 
 namespace Net
 {
-std::vector<uint8_t> wrapMessage(const uint8_t* message, const size_t length)
+size_t encodePrefix(uint8_t* dest, packet_size_t length, PrefixFormat format)
+{
+  switch (format) {
+    case PrefixFormat::fixed32:
+      for (size_t i = 0; i < 4; i++)
+        dest[i] = length >> (i * 8);
+      return 4;
+    case PrefixFormat::fixed64:
+      for (size_t i = 0; i < 8; i++)
+        dest[i] = length >> (i * 8);
+      return 8;
+    case PrefixFormat::varint: {
+      size_t i = 0;
+      while (length >= 0x80) {
+        dest[i++] = static_cast<uint8_t>(length) | 0x80;
+        length >>= 7;
+      }
+      dest[i++] = length;
+      return i;
+    }
+  }
+  return 0;
+}
+
+size_t decodePrefix(const uint8_t* data, size_t length, packet_size_t& packetSize, PrefixFormat format)
+{
+  switch (format) {
+    case PrefixFormat::fixed32:
+    case PrefixFormat::fixed64: {
+      size_t n = format == PrefixFormat::fixed32 ? 4 : 8;
+      if (length < n)
+        return 0;
+      packetSize = 0;
+      for (size_t i = 0; i < n; i++)
+        packetSize += static_cast<packet_size_t>(data[i]) << (i * 8);
+      return n;
+    }
+    case PrefixFormat::varint: {
+      packet_size_t size = 0;
+      size_t end = std::min(length, MAX_PREFIX_LENGTH);
+      for (size_t i = 0; i < end; i++) {
+        size |= static_cast<packet_size_t>(data[i] & 0x7f) << (i * 7);
+        if (!(data[i] & 0x80)) {
+          packetSize = size;
+          return i + 1;
+        }
+      }
+      if (length >= MAX_PREFIX_LENGTH)
+        throw "length prefix too long";
+      return 0;
+    }
+  }
+  return 0;
+}
+
+std::vector<uint8_t> wrapMessage(const uint8_t* message, const size_t length, PrefixFormat format)
 {
   std::vector<uint8_t> packet;
+  appendMessage(packet, message, length, format);
+  return packet;
+}
+
+void appendMessage(std::vector<uint8_t>& buf, const uint8_t* message, const size_t length, PrefixFormat format)
+{
   // insert length prefix
-  for (int i = 0; i < sizeof(packet_size_t); i++)
-    packet.push_back(length >> (i * 8));
+  uint8_t prefix[MAX_PREFIX_LENGTH];
+  buf.insert(buf.end(), prefix, prefix + encodePrefix(prefix, length, format));
   // insert message
-  packet.insert(packet.end(), message, message + length);
-  return packet;
+  buf.insert(buf.end(), message, message + length);
 }
 }  // namespace Net
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -6,68 +8,147 @@ namespace Net
 {
 typedef size_t packet_size_t;
 
+// encoding of the length prefix in front of every packet
+enum class PrefixFormat : uint8_t {
+  fixed32,  // 4 byte little endian
+  fixed64,  // 8 byte little endian (sizeof(packet_size_t), the original format)
+  varint    // LEB128, 1 to 10 bytes
+};
+
+// non-owning view of a received message, only valid during the msgHandler call
+struct ByteView {
+  const uint8_t* data;
+  size_t size;
+
+  const uint8_t* begin() const { return data; }
+  const uint8_t* end() const { return data + size; }
+  const uint8_t& operator[](size_t i) const { return data[i]; }
+};
+
+inline constexpr size_t MAX_PREFIX_LENGTH = 10;
+
+constexpr size_t prefixLength(PrefixFormat format, packet_size_t length)
+{
+  switch (format) {
+    case PrefixFormat::fixed32:
+      return 4;
+    case PrefixFormat::fixed64:
+      return 8;
+    case PrefixFormat::varint: {
+      size_t n = 1;
+      while (length >>= 7)
+        n++;
+      return n;
+    }
+  }
+  return 0;
+}
+
+// write length prefix to dest (at least MAX_PREFIX_LENGTH bytes) and return the number of bytes written
+size_t encodePrefix(uint8_t* dest, packet_size_t length, PrefixFormat format = PrefixFormat::fixed64);
+
+// decode length prefix from (possibly incomplete) data, return the number of bytes consumed or 0 if more bytes are needed
+size_t decodePrefix(const uint8_t* data, size_t length, packet_size_t& packetSize, PrefixFormat format = PrefixFormat::fixed64);
+
 // convert msg to byte vector with length prefix
-std::vector<uint8_t> wrapMessage(const uint8_t* msg, const size_t length);
+std::vector<uint8_t> wrapMessage(const uint8_t* msg, const size_t length, PrefixFormat format = PrefixFormat::fixed64);
+
+// append msg with length prefix to buf
+void appendMessage(std::vector<uint8_t>& buf, const uint8_t* msg, const size_t length, PrefixFormat format = PrefixFormat::fixed64);
 
 // class to decode length prefixed byte messages
-template <typename Func>
+// packets that lie completely inside the data passed to receive are handed to msgHandler as a view into that data,
+// only packets that straddle two receive calls are assembled in an internal buffer
+template <typename Func, PrefixFormat format = PrefixFormat::fixed64>
 class PacketProtocol
 {
  public:
-  // construct with msgHandler that gets called for every completely received message
+  // construct with msgHandler that gets called with a ByteView for every completely received message
   PacketProtocol(Func msgHandler) : msgHandler(msgHandler) {}
 
   // read (partial) length prefixed data in and call msgHandler whenever a complete packet was received
   void receive(const uint8_t* data, const size_t length)
   {
-    size_t i = 0;
-    while (i != length) {
-      size_t bytesAvailable = length - i;
-      if (readPacketSize) {
-        // read into sizeBuffer
-        size_t bytesToRead = sizeof(packet_size_t) - bytesReceived;
-        size_t bytesCopied = std::min(bytesToRead, bytesAvailable);
-        std::copy(data + i, data + i + bytesCopied, sizeBuffer + bytesReceived);
-        i += bytesCopied;
-        bytesReceived += bytesCopied;
-
-        if (bytesReceived == sizeof(packet_size_t)) {
-          // received complete packetSize
-          packetSize = 0;
-          for (size_t i = 0; i < sizeof(packet_size_t); i++)
-            packetSize += static_cast<packet_size_t>(sizeBuffer[i]) << (i * 8);
-
-          // clear dataBuffer and start reading into it
-          dataBuffer.clear();
-          bytesReceived = 0;
-          readPacketSize = false;
-        }
+    const uint8_t* pos = data;
+    const uint8_t* end = data + length;
+
+    // finish the packet left over from the last call
+    if (prefixBytes != 0 && !readPrefix(pos, end))
+      return;
+    if (!readPacketSize && !readBody(pos, end))
+      return;
+
+    while (pos != end) {
+      // fast path: prefix and message are contiguous in data
+      size_t available = end - pos;
+      size_t n = decodePrefix(pos, available, packetSize, format);
+      if (n == 0) {
+        // incomplete prefix
+        readPrefix(pos, end);
+        return;
+      }
+      pos += n;
+      available -= n;
+      if (packetSize <= available) {
+        msgHandler(ByteView{pos, packetSize});
+        pos += packetSize;
       } else {
-        // read into dataBuffer
-        size_t bytesToRead = packetSize - bytesReceived;
-        size_t bytesCopied = std::min(bytesToRead, bytesAvailable);
-        dataBuffer.insert(dataBuffer.end(), data + i, data + i + bytesCopied);
-        i += bytesCopied;
-        bytesReceived += bytesCopied;
-
-        if (bytesReceived == packetSize) {
-          // received complete packet
-          msgHandler(dataBuffer);
-
-          // start reading into length buffer
-          bytesReceived = 0;
-          readPacketSize = true;
-        }
+        // message continues in the next receive call
+        dataBuffer.clear();
+        readPacketSize = false;
+        readBody(pos, end);
+        return;
       }
     }
   }
 
+  // drop a partially received packet
+  void reset()
+  {
+    prefixBytes = 0;
+    readPacketSize = true;
+    dataBuffer.clear();
+  }
+
  private:
-  packet_size_t bytesReceived = 0;
+  size_t prefixBytes = 0;
   packet_size_t packetSize;
   bool readPacketSize = true;
-  uint8_t sizeBuffer[sizeof(packet_size_t)];
+  uint8_t sizeBuffer[MAX_PREFIX_LENGTH];
   std::vector<uint8_t> dataBuffer;
   const Func msgHandler;
+
+  // read into sizeBuffer until the prefix is complete, return true if it is
+  bool readPrefix(const uint8_t*& pos, const uint8_t* end)
+  {
+    while (pos != end) {
+      sizeBuffer[prefixBytes++] = *pos++;
+      if (decodePrefix(sizeBuffer, prefixBytes, packetSize, format) != 0) {
+        // received complete packetSize, clear dataBuffer and start reading into it
+        prefixBytes = 0;
+        dataBuffer.clear();
+        readPacketSize = false;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // read into dataBuffer until the packet is complete, return true if it is
+  bool readBody(const uint8_t*& pos, const uint8_t* end)
+  {
+    size_t bytesToRead = packetSize - dataBuffer.size();
+    size_t bytesCopied = std::min(bytesToRead, static_cast<size_t>(end - pos));
+    dataBuffer.insert(dataBuffer.end(), pos, pos + bytesCopied);
+    pos += bytesCopied;
+
+    if (dataBuffer.size() != packetSize)
+      return false;
+
+    // received complete packet
+    msgHandler(ByteView{dataBuffer.data(), dataBuffer.size()});
+    readPacketSize = true;
+    return true;
+  }
 };
 }  // namespace Net
@@ -0,0 +1,190 @@
+#include "ShmChannel.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Net
+{
+static constexpr uint64_t SEGMENT_MAGIC = 0x4442'4e53'484d'0001;  // "DBNSHM" v1
+static constexpr size_t SEGMENT_HEADER_SIZE = 64;
+
+bool ShmChannel::accept(int socket, size_t ringCapacity)
+{
+  side = Side::server;
+  control = socket;
+
+  int memfd = memfd_create("dbnetwork-shm", MFD_CLOEXEC);
+  if (memfd == -1) {
+    perror("memfd_create()");
+    exit(EXIT_FAILURE);
+  }
+  size_t size = SEGMENT_HEADER_SIZE + 2 * ShmRing::requiredSize(ringCapacity);
+  if (ftruncate(memfd, size) == -1) {
+    perror("ftruncate()");
+    exit(EXIT_FAILURE);
+  }
+  SegmentHeader header{SEGMENT_MAGIC, ringCapacity};
+  map(memfd, size, true);
+  memcpy(segment, &header, sizeof(header));
+  ShmRing::initialize(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE);
+  ShmRing::initialize(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE + ShmRing::requiredSize(ringCapacity));
+  clientToServer = ShmRing(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE, ringCapacity);
+  serverToClient = ShmRing(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE + ShmRing::requiredSize(ringCapacity), ringCapacity);
+
+  if ((serverDoorbell = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1 || (clientDoorbell = eventfd(0, EFD_CLOEXEC)) == -1) {
+    perror("eventfd()");
+    exit(EXIT_FAILURE);
+  }
+
+  // send segment size and the three fds
+  int fds[3] = {memfd, serverDoorbell, clientDoorbell};
+  uint64_t payload = size;
+  struct iovec iov = {&payload, sizeof(payload)};
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  ssize_t n;
+  while ((n = sendmsg(socket, &msg, MSG_NOSIGNAL)) == -1 && (errno == EAGAIN || errno == EINTR))
+    ;
+  // the mapping and the client keep the segment alive
+  ::close(memfd);
+  if (n == -1) {
+    // a client that hangs up mid-handshake is not worth a message
+    if (errno != EPIPE && errno != ECONNRESET)
+      perror("sendmsg()");
+    return false;
+  }
+  return true;
+}
+
+void ShmChannel::connect(const char* path)
+{
+  side = Side::client;
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  if ((control = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1) {
+    perror("socket()");
+    exit(EXIT_FAILURE);
+  }
+  if (::connect(control, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    perror("connect()");
+    exit(EXIT_FAILURE);
+  }
+
+  // receive segment size and fds
+  int fds[3];
+  uint64_t size;
+  struct iovec iov = {&size, sizeof(size)};
+  char buf[CMSG_SPACE(sizeof(fds))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = buf;
+  msg.msg_controllen = sizeof(buf);
+  if (recvmsg(control, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC) != sizeof(size)) {
+    perror("recvmsg()");
+    exit(EXIT_FAILURE);
+  }
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+    fprintf(stderr, "shm handshake: missing file descriptors\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+  serverDoorbell = fds[1];
+  clientDoorbell = fds[2];
+
+  map(fds[0], size, false);
+  ::close(fds[0]);
+  SegmentHeader header;
+  memcpy(&header, segment, sizeof(header));
+  if (header.magic != SEGMENT_MAGIC || SEGMENT_HEADER_SIZE + 2 * ShmRing::requiredSize(header.ringCapacity) != size) {
+    fprintf(stderr, "shm handshake: invalid segment\n");
+    exit(EXIT_FAILURE);
+  }
+  clientToServer = ShmRing(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE, header.ringCapacity);
+  serverToClient = ShmRing(static_cast<uint8_t*>(segment) + SEGMENT_HEADER_SIZE + ShmRing::requiredSize(header.ringCapacity), header.ringCapacity);
+}
+
+void ShmChannel::map(int memfd, size_t size, bool initialize)
+{
+  segmentSize = size;
+  segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | (initialize ? MAP_POPULATE : 0), memfd, 0);
+  if (segment == MAP_FAILED) {
+    perror("mmap()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void ShmChannel::close()
+{
+  if (segment)
+    munmap(segment, segmentSize);
+  segment = nullptr;
+  for (int* fd : {&control, &serverDoorbell, &clientDoorbell}) {
+    if (*fd != -1)
+      ::close(*fd);
+    *fd = -1;
+  }
+}
+
+void ShmChannel::ring()
+{
+  if (eventfd_write(side == Side::server ? clientDoorbell : serverDoorbell, 1) == -1) {
+    perror("eventfd_write()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void ShmChannel::waitDoorbell()
+{
+  eventfd_t value;
+  // EAGAIN if the doorbell was not rung, that's fine
+  eventfd_read(doorbell(), &value);
+}
+
+void ShmChannel::writeAll(const uint8_t* data, size_t length)
+{
+  ShmRing& ring = outRing();
+  while (length != 0) {
+    size_t n = ring.write(data, length);
+    data += n;
+    length -= n;
+    if (n != 0 && ring.takeConsumerWaiting())
+      this->ring();
+    if (length != 0 && ring.prepareProducerWait())
+      waitDoorbell();
+  }
+}
+
+void ShmChannel::awaitData()
+{
+  ShmRing& ring = inRing();
+  while (ring.empty()) {
+    if (ring.prepareConsumerWait())
+      waitDoorbell();
+  }
+}
+}  // namespace Net
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "ShmRing.hpp"
+
+namespace Net
+{
+// bidirectional channel between a co-located client and the server: two ShmRings in one memfd segment
+// the server creates the segment and two eventfd doorbells and passes them to the client over a Unix domain socket
+// a side only rings the other side's doorbell if that side announced that it goes to sleep, so a busy channel needs no syscalls
+class ShmChannel
+{
+ public:
+  enum class Side { server, client };
+
+  ShmChannel() = default;
+  ShmChannel(const ShmChannel&) = delete;
+  ShmChannel& operator=(const ShmChannel&) = delete;
+  ~ShmChannel() { close(); }
+
+  // server: set up a new segment with rings of ringCapacity bytes (power of two) and hand it to the client on socket
+  // false if the client went away during the handshake, the channel owns socket either way and must be closed then
+  bool accept(int socket, size_t ringCapacity);
+  // client: connect to the server's Unix domain socket at path and map the segment it sends
+  void connect(const char* path);
+  void close();
+
+  bool isOpen() const { return segment != nullptr; }
+
+  // the ring this side writes to and the one it reads from
+  ShmRing& outRing() { return side == Side::server ? serverToClient : clientToServer; }
+  ShmRing& inRing() { return side == Side::server ? clientToServer : serverToClient; }
+
+  // eventfd this side sleeps on, readable when the other side rang it
+  int doorbell() const { return side == Side::server ? serverDoorbell : clientDoorbell; }
+  // Unix domain socket of the handshake, kept open to detect when the other side goes away
+  int controlSocket() const { return control; }
+
+  // wake the other side
+  void ring();
+  // consume a ring of this side's doorbell
+  // blocks on the client side, returns right away on the server side whose doorbell is non-blocking and polled by epoll
+  void waitDoorbell();
+
+  // pass readable parts of the in ring to handler until it is empty or limit bytes were consumed
+  // wakes the other side if it waits for space, returns the number of bytes consumed
+  template <typename Func>
+  size_t drain(Func&& handler, size_t limit = std::numeric_limits<size_t>::max())
+  {
+    ShmRing& ring = inRing();
+    size_t consumed = 0;
+    while (consumed < limit) {
+      ByteView view = ring.readable();
+      if (view.size == 0)
+        break;
+      view.size = std::min(view.size, limit - consumed);
+      handler(view);
+      ring.consume(view.size);
+      consumed += view.size;
+    }
+    if (consumed != 0 && ring.takeProducerWaiting())
+      this->ring();
+    return consumed;
+  }
+
+  // write all of data, sleeping on the doorbell while the out ring is full (client side)
+  void writeAll(const uint8_t* data, size_t length);
+  // sleep on the doorbell until the in ring has data (client side)
+  void awaitData();
+
+ private:
+  struct SegmentHeader {
+    uint64_t magic;
+    uint64_t ringCapacity;
+  };
+
+  Side side;
+  void* segment = nullptr;
+  size_t segmentSize = 0;
+  ShmRing clientToServer;
+  ShmRing serverToClient;
+  int control = -1;
+  int serverDoorbell = -1;
+  int clientDoorbell = -1;
+
+  void map(int memfd, size_t size, bool initialize);
+};
+}  // namespace Net
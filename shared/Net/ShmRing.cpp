@@ -0,0 +1,83 @@
+#include "ShmRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace Net
+{
+ShmRing::ShmRing(void* memory, size_t capacity)
+    : header(static_cast<ShmRingHeader*>(memory)), data(static_cast<uint8_t*>(memory) + sizeof(ShmRingHeader)), capacity(capacity)
+{
+}
+
+void ShmRing::initialize(void* memory)
+{
+  ShmRingHeader* header = new (memory) ShmRingHeader;
+  header->head = 0;
+  header->tail = 0;
+  // the consumer counts as sleeping until it first drained the ring, so the first write always rings its doorbell
+  header->consumerWaiting = 1;
+  header->producerWaiting = 0;
+}
+
+size_t ShmRing::write(const uint8_t* src, size_t length)
+{
+  uint64_t head = header->head.load(std::memory_order_relaxed);
+  uint64_t tail = header->tail.load(std::memory_order_acquire);
+  size_t n = std::min(length, static_cast<size_t>(capacity - (head - tail)));
+  size_t offset = head & (capacity - 1);
+  size_t first = std::min(n, capacity - offset);
+  memcpy(data + offset, src, first);
+  memcpy(data, src + first, n - first);
+  header->head.store(head + n, std::memory_order_release);
+  return n;
+}
+
+ByteView ShmRing::readable() const
+{
+  uint64_t tail = header->tail.load(std::memory_order_relaxed);
+  uint64_t head = header->head.load(std::memory_order_acquire);
+  size_t offset = tail & (capacity - 1);
+  return ByteView{data + offset, std::min(static_cast<size_t>(head - tail), capacity - offset)};
+}
+
+void ShmRing::consume(size_t length)
+{
+  header->tail.store(header->tail.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+// the seq_cst store of the waiting flag followed by the seq_cst load of the other side's position pairs with the
+// seq_cst position update and flag exchange in take*Waiting, so at least one side sees the other
+bool ShmRing::prepareConsumerWait()
+{
+  header->consumerWaiting.store(1);
+  if (header->head.load() != header->tail.load(std::memory_order_relaxed)) {
+    header->consumerWaiting.store(0);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::prepareProducerWait()
+{
+  header->producerWaiting.store(1);
+  if (header->head.load(std::memory_order_relaxed) - header->tail.load() != capacity) {
+    header->producerWaiting.store(0);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::takeConsumerWaiting()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return header->consumerWaiting.load(std::memory_order_relaxed) && header->consumerWaiting.exchange(0);
+}
+
+bool ShmRing::takeProducerWaiting()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return header->producerWaiting.load(std::memory_order_relaxed) && header->producerWaiting.exchange(0);
+}
+}  // namespace Net
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "PacketProtocol.hpp"
+
+namespace Net
+{
+// control block of a ring, lives in shared memory in front of the ring data
+struct ShmRingHeader {
+  // bytes ever written, only advanced by the producer
+  alignas(64) std::atomic<uint64_t> head;
+  // bytes ever read, only advanced by the consumer
+  alignas(64) std::atomic<uint64_t> tail;
+  // set by a side before it goes to sleep on its doorbell, the other side rings the doorbell only if this is set
+  alignas(64) std::atomic<uint32_t> consumerWaiting;
+  alignas(64) std::atomic<uint32_t> producerWaiting;
+};
+
+// single producer single consumer byte ring in shared memory
+// carries the same byte stream as a TCP connection, so length prefixes and the TPC-C wire format work unchanged
+class ShmRing
+{
+ public:
+  ShmRing() = default;
+  // memory points to requiredSize(capacity) bytes, capacity must be a power of two
+  ShmRing(void* memory, size_t capacity);
+
+  static size_t requiredSize(size_t capacity) { return sizeof(ShmRingHeader) + capacity; }
+  // zero the control block, done once by the side that creates the segment
+  static void initialize(void* memory);
+
+  // producer: copy up to length bytes into the ring, return the number of bytes copied
+  size_t write(const uint8_t* data, size_t length);
+  // consumer: first contiguous readable part of the ring, empty if there is nothing to read
+  ByteView readable() const;
+  void consume(size_t length);
+
+  bool empty() const { return header->head.load(std::memory_order_acquire) == header->tail.load(std::memory_order_relaxed); }
+  bool full() const { return header->head.load(std::memory_order_relaxed) - header->tail.load(std::memory_order_acquire) == capacity; }
+
+  // announce that the consumer is about to sleep, returns false if data arrived in the meantime and it must not
+  bool prepareConsumerWait();
+  // announce that the producer is about to sleep, returns false if space was freed in the meantime and it must not
+  bool prepareProducerWait();
+  // called after write / consume: true if the other side sleeps and its doorbell has to be rung
+  bool takeConsumerWaiting();
+  bool takeProducerWaiting();
+
+ private:
+  ShmRingHeader* header = nullptr;
+  uint8_t* data = nullptr;
+  size_t capacity = 0;
+};
+}  // namespace Net
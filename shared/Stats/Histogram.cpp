@@ -0,0 +1,47 @@
+#include "Histogram.hpp"
+
+#include <algorithm>
+
+namespace Stats
+{
+void Histogram::merge(const Histogram& other)
+{
+  for (size_t i = 0; i < BUCKET_COUNT; i++)
+    buckets[i] += other.buckets[i];
+  total += other.total;
+  sum += other.sum;
+  maxValue = std::max(maxValue, other.maxValue);
+}
+
+void Histogram::reset()
+{
+  buckets.fill(0);
+  total = 0;
+  sum = 0;
+  maxValue = 0;
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+  if (total == 0)
+    return 0;
+  uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * total + 0.5));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; i++) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min(bucketUpperBound(i), maxValue);
+  }
+  return maxValue;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index)
+{
+  if (index < (1ull << SUB_BUCKET_BITS))
+    return index;
+  size_t shift = (index >> (SUB_BUCKET_BITS - 1)) - 1;
+  uint64_t subBucket = (index & ((1ull << (SUB_BUCKET_BITS - 1)) - 1)) + (1ull << (SUB_BUCKET_BITS - 1));
+  // wraps to UINT64_MAX for the last bucket
+  return ((subBucket + 1) << shift) - 1;
+}
+}  // namespace Stats
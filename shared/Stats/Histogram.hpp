@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Stats
+{
+// log-linear histogram for latencies in ns
+// values below 2^SUB_BUCKET_BITS are counted exactly, above that every power of two is split into 2^(SUB_BUCKET_BITS - 1)
+// buckets, so a reported percentile is at most ~3% above the recorded value
+class Histogram
+{
+ public:
+  static constexpr int SUB_BUCKET_BITS = 6;
+  // the exact buckets and every power of two from 2^SUB_BUCKET_BITS up to 2^63, so any uint64_t has a bucket
+  static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 2) << (SUB_BUCKET_BITS - 1);
+
+  void record(uint64_t value)
+  {
+    buckets[bucketIndex(value)]++;
+    total++;
+    sum += value;
+    if (value > maxValue)
+      maxValue = value;
+  }
+
+  void merge(const Histogram& other);
+  void reset();
+
+  // upper bound of the bucket holding the p-quantile, p in [0, 1]
+  uint64_t percentile(double p) const;
+
+  uint64_t count() const { return total; }
+  uint64_t max() const { return maxValue; }
+  double mean() const { return total ? static_cast<double>(sum) / total : 0; }
+
+  const std::array<uint64_t, BUCKET_COUNT>& getBuckets() const { return buckets; }
+
+ private:
+  std::array<uint64_t, BUCKET_COUNT> buckets{};
+  uint64_t total = 0;
+  uint64_t sum = 0;
+  uint64_t maxValue = 0;
+
+  static size_t bucketIndex(uint64_t value)
+  {
+    if (value < (1ull << SUB_BUCKET_BITS))
+      return value;
+    int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS + 1;
+    return (static_cast<size_t>(shift) << (SUB_BUCKET_BITS - 1)) + (value >> shift);
+  }
+
+  static uint64_t bucketUpperBound(size_t index);
+};
+}  // namespace Stats
@@ -0,0 +1,64 @@
+#include "Affinity.hpp"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace Sys
+{
+std::vector<int> parseCoreList(const std::string& list)
+{
+  std::vector<int> cores;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos)
+      end = list.size();
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    if (first < 0 || last < first)
+      throw std::invalid_argument("invalid core range " + range);
+    for (int core = first; core <= last; core++)
+      cores.push_back(core);
+    pos = end + 1;
+  }
+  return cores;
+}
+
+void pinThread(int core)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    fprintf(stderr, "pthread_setaffinity_np(%d): %s\n", core, strerror(error));
+    exit(EXIT_FAILURE);
+  }
+}
+
+int numaNode(int core)
+{
+  // the cpu directory contains a nodeN link for the node the core belongs to
+  std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+  DIR* dir = opendir(path.c_str());
+  if (!dir)
+    return 0;
+  int node = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+      node = atoi(entry->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+}  // namespace Sys
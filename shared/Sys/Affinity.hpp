@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Sys
+{
+// parse a core list like "0-3,8,10-11"
+std::vector<int> parseCoreList(const std::string& list);
+
+// pin the calling thread to core
+// memory the thread touches first afterwards is allocated on the core's NUMA node under the default (local) memory policy,
+// so per-thread state should be created after pinning
+void pinThread(int core);
+
+// NUMA node of core, 0 if it can't be determined
+int numaNode(int core);
+}  // namespace Sys
@@ -0,0 +1,97 @@
+#include "HugePages.hpp"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+namespace Sys
+{
+namespace
+{
+std::atomic<HugePagePolicy> policy{HugePagePolicy::transparent};
+std::atomic<size_t> mapped[PAGE_BACKING_COUNT];
+
+// backing of every live mapping, mappings are large and rare, so a locked map is cheap enough
+std::mutex mappingsLatch;
+std::map<void*, PageBacking> mappings;
+
+size_t roundUp(size_t size)
+{
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+void* mapAligned(size_t size)
+{
+  // over-allocate by one huge page and trim, so the kernel can use huge pages from the first byte
+  size_t length = size + HUGE_PAGE_SIZE;
+  void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap()");
+    exit(EXIT_FAILURE);
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  if (aligned != begin)
+    munmap(p, aligned - begin);
+  if (aligned + size != begin + length)
+    munmap(reinterpret_cast<void*>(aligned + size), begin + length - aligned - size);
+  return reinterpret_cast<void*>(aligned);
+}
+}  // namespace
+
+void setHugePagePolicy(HugePagePolicy newPolicy)
+{
+  policy = newPolicy;
+}
+
+HugePagePolicy getHugePagePolicy()
+{
+  return policy;
+}
+
+void* mapPages(size_t size)
+{
+  size = roundUp(size);
+  void* p = MAP_FAILED;
+  PageBacking backing = PageBacking::small;
+  if (policy == HugePagePolicy::hugetlb) {
+    p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    backing = PageBacking::hugetlb;
+  }
+  if (p == MAP_FAILED) {
+    p = mapAligned(size);
+    backing = PageBacking::small;
+    if (policy != HugePagePolicy::off && madvise(p, size, MADV_HUGEPAGE) == 0)
+      backing = PageBacking::transparent;
+  }
+
+  mapped[static_cast<size_t>(backing)] += size;
+  std::lock_guard<std::mutex> guard(mappingsLatch);
+  mappings.emplace(p, backing);
+  return p;
+}
+
+void unmapPages(void* address, size_t size)
+{
+  size = roundUp(size);
+  {
+    std::lock_guard<std::mutex> guard(mappingsLatch);
+    auto it = mappings.find(address);
+    mapped[static_cast<size_t>(it->second)] -= size;
+    mappings.erase(it);
+  }
+  if (munmap(address, size) == -1) {
+    perror("munmap()");
+    exit(EXIT_FAILURE);
+  }
+}
+
+size_t mappedBytes(PageBacking backing)
+{
+  return mapped[static_cast<size_t>(backing)];
+}
+}  // namespace Sys
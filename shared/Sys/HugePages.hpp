@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace Sys
+{
+inline constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+enum class HugePagePolicy {
+  off,          // 4 KB pages
+  transparent,  // madvise(MADV_HUGEPAGE), the kernel backs the mapping with huge pages when it can
+  hugetlb       // MAP_HUGETLB from the reserved pool (vm.nr_hugepages), transparent if the pool is exhausted
+};
+
+// how a mapping ended up being backed, every mapping is counted once
+enum class PageBacking { hugetlb, transparent, small };
+inline constexpr size_t PAGE_BACKING_COUNT = 3;
+
+// process wide, set before the first mapping
+void setHugePagePolicy(HugePagePolicy policy);
+HugePagePolicy getHugePagePolicy();
+
+// anonymous private mapping of size rounded up to HUGE_PAGE_SIZE, aligned to HUGE_PAGE_SIZE, backed according to the
+// policy with a fallback to 4 KB pages
+void* mapPages(size_t size);
+void unmapPages(void* address, size_t size);
+// bytes currently mapped with each backing
+size_t mappedBytes(PageBacking backing);
+
+// allocations of at least HUGE_ALLOCATION_THRESHOLD bytes that are usually the big, randomly accessed arrays of a
+// container get their own huge page backed mapping, smaller ones come from the heap
+inline constexpr size_t HUGE_ALLOCATION_THRESHOLD = HUGE_PAGE_SIZE / 2;
+
+template <typename T>
+struct HugePageAllocator {
+  using value_type = T;
+
+  HugePageAllocator() = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&)
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    size_t size = n * sizeof(T);
+    if (size >= HUGE_ALLOCATION_THRESHOLD)
+      return static_cast<T*>(mapPages(size));
+    if (void* p = std::malloc(size))
+      return static_cast<T*>(p);
+    throw std::bad_alloc();
+  }
+
+  void deallocate(T* p, size_t n)
+  {
+    size_t size = n * sizeof(T);
+    if (size >= HUGE_ALLOCATION_THRESHOLD)
+      unmapPages(p, size);
+    else
+      std::free(p);
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const
+  {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U>&) const
+  {
+    return false;
+  }
+};
+}  // namespace Sys
@@ -0,0 +1,47 @@
+#include "PerfCounter.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace Sys
+{
+PageFaults pageFaults()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return {static_cast<uint64_t>(usage.ru_minflt), static_cast<uint64_t>(usage.ru_majflt)};
+}
+
+void PerfCounter::open(Event event)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HW_CACHE;
+  uint64_t cache = event == Event::dataTlbMisses ? PERF_COUNT_HW_CACHE_DTLB : PERF_COUNT_HW_CACHE_ITLB;
+  attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // calling thread on any cpu
+  fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+PerfCounter::~PerfCounter()
+{
+  if (fd != -1)
+    close(fd);
+}
+
+uint64_t PerfCounter::read() const
+{
+  uint64_t value = 0;
+  int counter = fd;
+  if (counter == -1 || ::read(counter, &value, sizeof(value)) != sizeof(value))
+    return 0;
+  return value;
+}
+}  // namespace Sys
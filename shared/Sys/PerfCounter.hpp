@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace Sys
+{
+// minor and major page faults of the whole process since it started
+struct PageFaults {
+  uint64_t minor;
+  uint64_t major;
+};
+PageFaults pageFaults();
+
+// hardware counter of the calling thread, user space only, so it works with perf_event_paranoid <= 2
+// the value can be read from any thread, also while the owning thread opens it; counters the kernel or the hypervisor
+// does not offer stay closed
+class PerfCounter
+{
+ public:
+  enum class Event { dataTlbMisses, instructionTlbMisses };
+
+  PerfCounter() = default;
+  explicit PerfCounter(Event event) { open(event); }
+  ~PerfCounter();
+  PerfCounter(const PerfCounter&) = delete;
+  PerfCounter& operator=(const PerfCounter&) = delete;
+
+  // counts event for the calling thread from now on
+  void open(Event event);
+  bool isOpen() const { return fd != -1; }
+  // events counted so far, 0 if the counter is closed
+  uint64_t read() const;
+
+ private:
+  std::atomic<int> fd{-1};
+};
+}  // namespace Sys
@@ -0,0 +1,83 @@
+#include "Random.hpp"
+
+#include <cstdlib>
+
+namespace TPCC
+{
+// [0, n)
+Integer rnd(Integer n)
+{
+  return leanstore::utils::RandomGenerator::getRand(0, n);
+}
+
+// [fromId, toId]
+Integer randomId(Integer fromId, Integer toId)
+{
+  return leanstore::utils::RandomGenerator::getRand(fromId, toId + 1);
+}
+
+// [low, high]
+Integer urand(Integer low, Integer high)
+{
+  return rnd(high - low + 1) + low;
+}
+
+Integer urandexcept(Integer low, Integer high, Integer v)
+{
+  if (high <= low)
+    return low;
+  Integer r = rnd(high - low) + low;
+  if (r >= v)
+    return r + 1;
+  else
+    return r;
+}
+
+Varchar<16> randomnstring(Integer minLenStr, Integer maxLenStr)
+{
+  Integer len = rnd(maxLenStr - minLenStr + 1) + minLenStr;
+  Varchar<16> result;
+  for (Integer i = 0; i < len; i++)
+    result.append(48 + rnd(10));
+  return result;
+}
+
+Varchar<16> namePart(Integer id)
+{
+  assert(id < 10);
+  Varchar<16> data[] = {"Bar", "OUGHT", "ABLE", "PRI", "PRES", "ESE", "ANTI", "CALLY", "ATION", "EING"};
+  return data[id];
+}
+
+Varchar<16> genName(Integer id)
+{
+  return namePart((id / 100) % 10) || namePart((id / 10) % 10) || namePart(id % 10);
+}
+
+Numeric randomNumeric(Numeric min, Numeric max)
+{
+  double range = (max - min);
+  double div = RAND_MAX / range;
+  return min + (leanstore::utils::RandomGenerator::getRandU64() / div);
+}
+
+Varchar<9> randomzip()
+{
+  Integer id = rnd(10000);
+  Varchar<9> result;
+  result.append(48 + (id / 1000));
+  result.append(48 + (id / 100) % 10);
+  result.append(48 + (id / 10) % 10);
+  result.append(48 + (id % 10));
+  return result || Varchar<9>("11111");
+}
+
+Integer nurand(Integer a, Integer x, Integer y, Integer C)
+{
+  // TPC-C random is [a,b] inclusive
+  // in standard: NURand(A, x, y) = (((random(0, A) | random(x, y)) + C) % (y - x + 1)) + x
+  // return (((rnd(a + 1) | rnd((y - x + 1) + x)) + 42) % (y - x + 1)) + x;
+  return (((urand(0, a) | urand(x, y)) + C) % (y - x + 1)) + x;
+  // incorrect: return (((rnd(a) | rnd((y - x + 1) + x)) + 42) % (y - x + 1)) + x;
+}
+}  // namespace TPCC
@@ -0,0 +1,75 @@
+#pragma once
+#include <cassert>
+
+#include "TPCC/RandomGenerator.hpp"
+#include "TPCC/Types.hpp"
+
+// random helpers of spec 4.3.2 and 2.1.6, shared by the client's workload and the server's loader
+// they draw from the calling thread's generator, RandomGenerator::seed makes a thread repeat a sequence
+namespace TPCC
+{
+// -------------------------------------------------------------------------------------
+static constexpr Integer OL_I_ID_C = 7911;  // in range [0, 8191]
+static constexpr Integer C_ID_C = 259;      // in range [0, 1023]
+// NOTE: TPC-C 2.1.6.1 specifies that abs(C_LAST_LOAD_C - C_LAST_RUN_C) must
+// be within [65, 119]
+static constexpr Integer C_LAST_LOAD_C = 157;  // in range [0, 255]
+static constexpr Integer C_LAST_RUN_C = 223;   // in range [0, 255]
+// -------------------------------------------------------------------------------------
+static constexpr Integer ITEMS_NO = 100000;  // 100K
+
+// [0, n)
+Integer rnd(Integer n);
+// [fromId, toId]
+Integer randomId(Integer fromId, Integer toId);
+// [low, high]
+Integer urand(Integer low, Integer high);
+Integer urandexcept(Integer low, Integer high, Integer v);
+
+template <int maxLength>
+Varchar<maxLength> randomastring(Integer minLenStr, Integer maxLenStr)
+{
+  assert(maxLenStr <= maxLength);
+  Integer len = rnd(maxLenStr - minLenStr + 1) + minLenStr;
+  Varchar<maxLength> result;
+  for (Integer index = 0; index < len; index++) {
+    Integer i = rnd(62);
+    if (i < 10)
+      result.append(48 + i);
+    else if (i < 36)
+      result.append(64 - 10 + i);
+    else
+      result.append(96 - 36 + i);
+  }
+  return result;
+}
+
+Varchar<16> randomnstring(Integer minLenStr, Integer maxLenStr);
+Varchar<16> namePart(Integer id);
+Varchar<16> genName(Integer id);
+Numeric randomNumeric(Numeric min, Numeric max);
+Varchar<9> randomzip();
+Integer nurand(Integer a, Integer x, Integer y, Integer C = 42);
+
+inline Integer getItemID()
+{
+  // OL_I_ID_C
+  return nurand(8191, 1, ITEMS_NO, OL_I_ID_C);
+}
+inline Integer getCustomerID()
+{
+  // C_ID_C
+  return nurand(1023, 1, 3000, C_ID_C);
+  // return urand(1, 3000);
+}
+inline Integer getNonUniformRandomLastNameForRun()
+{
+  // C_LAST_RUN_C
+  return nurand(255, 0, 999, C_LAST_RUN_C);
+}
+inline Integer getNonUniformRandomLastNameForLoad()
+{
+  // C_LAST_LOAD_C
+  return nurand(255, 0, 999, C_LAST_LOAD_C);
+}
+}  // namespace TPCC
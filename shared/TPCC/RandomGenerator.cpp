@@ -14,6 +14,11 @@ MersenneTwister::MersenneTwister(uint64_t seed) : mti(NN + 1)
   init(seed + (mt_counter++));
 }
 // -------------------------------------------------------------------------------------
+void MersenneTwister::seed(uint64_t seed)
+{
+  init(seed);
+}
+// -------------------------------------------------------------------------------------
 void MersenneTwister::init(uint64_t seed)
 {
   mt[0] = seed;
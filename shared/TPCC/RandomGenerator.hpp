@@ -24,13 +24,16 @@ class MersenneTwister
 
  public:
   MersenneTwister(uint64_t seed = 19650218ULL);
+  // restart the sequence, the same seed gives the same numbers on every thread
+  void seed(uint64_t seed);
   uint64_t rnd();
 };
 }  // namespace utils
 }  // namespace leanstore
 // -------------------------------------------------------------------------------------
-static thread_local leanstore::utils::MersenneTwister mt_generator;
-static thread_local std::mt19937 random_generator;
+// one generator per thread in the whole program, not per translation unit, so it can be seeded from anywhere
+inline thread_local leanstore::utils::MersenneTwister mt_generator;
+inline thread_local std::mt19937 random_generator;
 // -------------------------------------------------------------------------------------
 namespace leanstore
 {
@@ -49,6 +52,7 @@ class RandomGenerator
     return rand;
   }
   static uint64_t getRandU64() { return mt_generator.rnd(); }
+  static void seed(uint64_t seed) { mt_generator.seed(seed); }
   static uint64_t getRandU64STD(uint64_t min, uint64_t max)
   {
     std::uniform_int_distribution<uint64_t> distribution(min, max - 1);
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+#include "PacketProtocol.hpp"
+
+namespace TPCC
+{
+// every request is answered with a length prefixed response frame: [function id][response code][payload]
+// ResponseCode::ok carries a 4 byte big endian result: the o_id of a NewOrder, the c_id a Payment was booked on,
+// the o_id of the customer's last order for OrderStatus, the number of low stock items for StockLevel and the
+// number of delivered orders for Delivery, 0 if the server defers Deliveries and only queued it
+// a server started with --echo-timing appends 4 big endian u32 durations in ns to every response: parse, queue,
+// execute and commit (see server/TPCCPhaseStats.hpp), their sum is the time the request spent in the server
+// a batch frame carries several requests to be answered together: [BATCH_FRAME_ID][count][count requests], count
+// 1 - 255. Its requests are answered by a single response frame [BATCH_FRAME_ID][count][count entries], an entry is
+// [function id][response code][result] with the result present for every code, 0 unless ok, followed by the timing
+// of --echo-timing, so all entries of a frame have the same size
+inline constexpr uint8_t BATCH_FRAME_ID = 8;
+inline constexpr Net::PrefixFormat RESPONSE_PREFIX_FORMAT = Net::PrefixFormat::varint;
+inline constexpr size_t RESPONSE_HEADER_SIZE = 2;
+inline constexpr size_t RESPONSE_RESULT_SIZE = 4;
+inline constexpr size_t RESPONSE_TIMING_SIZE = 16;
+inline constexpr size_t BATCH_HEADER_SIZE = 2;
+inline constexpr size_t BATCH_ENTRY_SIZE = RESPONSE_HEADER_SIZE + RESPONSE_RESULT_SIZE;
+
+enum class ResponseCode : uint8_t {
+  ok = 0,
+  // rejected by admission control without being executed, the client may retry later
+  busy = 1,
+  // rolled back as the spec requires, e.g. a NewOrder with an unused item id
+  aborted = 2,
+  // ids out of range, nothing was executed
+  invalid = 3
+};
+}  // namespace TPCC